@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "hardware_conc.hpp"
+#include "thread_pool.hpp"
+
+// Runtime tuning of how many threads the memory-bandwidth-bound algorithms
+// (count, count_if and equal over random access ranges) run on. On large
+// arrays these are limited by memory rather than by cores, and running them
+// on every thread often makes them slower, besides taking cores away from
+// everything else on the machine.
+//
+// The controller is off by default; when enabled, the parallel overloads of
+// these algorithms ask it how many chunks to split a range into (every chunk
+// runs on one thread, so this bounds the number of threads working on the
+// call) and report back how long the call took. Decisions are kept per
+// algorithm and size class (sizes with the same highest set bit). Every
+// candidate concurrency, the powers of two up to the default 2 * hardware
+// concurrency, is first tried a few times; after that the one with the best
+// measured throughput is used, and every so often a neighbouring one is tried
+// again so that the choice follows changes in the load of the machine.
+//
+//     using namespace experimental::parallel;
+//
+//     adaptive_concurrency::instance().enable();
+//     ... count(par, ...), equal(par, ...) ...
+//     for(auto& d : adaptive_concurrency::instance().stats()) {
+//         std::cout << d.min_size << ": " << d.concurrency << '\n';
+//     }
+//
+// Ranges smaller than adaptive_min_size are not tracked and always use the
+// default chunk count.
+
+namespace experimental
+{
+namespace parallel
+{
+
+//================================================================================
+
+enum class adaptive_kernel
+    : std::uint8_t
+{ count, equal };
+
+constexpr std::size_t adaptive_min_size = std::size_t(1) << 16;
+
+// What has been measured for one concurrency in one size class.
+struct adaptive_candidate
+{
+    std::size_t concurrency;
+    std::size_t samples;
+    double throughput;              // elements per second, moving average
+};
+
+// The controller's current choice for one algorithm and size class, which
+// covers the sizes in [min_size, max_size].
+struct adaptive_decision
+{
+    adaptive_kernel kernel;
+    std::size_t min_size;
+    std::size_t max_size;
+    std::size_t concurrency;
+    std::size_t calls;
+    std::vector<adaptive_candidate> candidates;
+};
+
+class adaptive_concurrency
+{
+public:
+
+    // Samples taken of every candidate before the controller starts choosing.
+    static constexpr std::size_t warmup_samples = 3;
+
+    // One call in this many tries a neighbour of the best candidate.
+    static constexpr std::size_t explore_interval = 32;
+
+    // Weight of a new sample in the moving average of the throughput.
+    static constexpr double smoothing = 0.25;
+
+    static adaptive_concurrency& instance()
+    {
+        static adaptive_concurrency controller;
+        return controller;
+    }
+
+    void enable(bool on = true) { on_.store(on, std::memory_order_relaxed); }
+
+    bool enabled() const { return on_.load(std::memory_order_relaxed); }
+
+    // Forgets everything that has been measured.
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        classes.clear();
+    }
+
+    std::vector<adaptive_decision> stats() const
+    {
+        std::lock_guard<std::mutex> lock(m);
+        std::vector<adaptive_decision> result;
+        for(auto& c : classes) {
+            const auto bit = c.first.second;
+            result.push_back(adaptive_decision{
+                c.first.first,
+                std::size_t(1) << bit,
+                (std::size_t(2) << bit) - 1,
+                c.second.candidates[c.second.best()].concurrency,
+                c.second.calls,
+                c.second.candidates
+            });
+        }
+        return result;
+    }
+
+    // Number of chunks to split a range of the given size into; 0 means the
+    // controller has no opinion and the default should be used. Every
+    // parallel call asks, so the lock is only taken when the answer can be
+    // something else.
+    std::size_t choose(adaptive_kernel kernel, std::size_t size)
+    {
+        if(!enabled() || size < adaptive_min_size) { return 0; }
+        std::lock_guard<std::mutex> lock(m);
+        return size_class(kernel, size).choose();
+    }
+
+    void record(adaptive_kernel kernel, std::size_t size, std::size_t concurrency,
+                std::chrono::steady_clock::duration elapsed)
+    {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        if(seconds <= 0) { return; }
+
+        if(!enabled() || size < adaptive_min_size) { return; }
+        std::lock_guard<std::mutex> lock(m);
+        size_class(kernel, size).record(concurrency, static_cast<double>(size) / seconds);
+    }
+
+private:
+
+    class class_state
+    {
+    public:
+
+        class_state()
+        {
+            const std::size_t most = 2 * get_hardware_concurrency_or_default();
+            for(std::size_t c = 1; c < most; c *= 2) {
+                candidates.push_back(adaptive_candidate{c, 0, 0.0});
+            }
+            candidates.push_back(adaptive_candidate{most, 0, 0.0});
+        }
+
+        std::size_t choose()
+        {
+            ++calls;
+
+            auto fewest = std::min_element(candidates.begin(), candidates.end(),
+                [](const adaptive_candidate& a, const adaptive_candidate& b)
+                { return a.samples < b.samples; });
+            if(fewest->samples < warmup_samples) { return fewest->concurrency; }
+
+            const auto b = best();
+            if(calls % explore_interval == 0) {
+                const bool up = (calls / explore_interval) % 2 == 0;
+                if(up && b + 1 < candidates.size()) { return candidates[b + 1].concurrency; }
+                if(!up && b > 0) { return candidates[b - 1].concurrency; }
+            }
+            return candidates[b].concurrency;
+        }
+
+        void record(std::size_t concurrency, double throughput)
+        {
+            for(auto& c : candidates) {
+                if(c.concurrency != concurrency) { continue; }
+                c.throughput = c.samples == 0
+                    ? throughput
+                    : (1 - smoothing) * c.throughput + smoothing * throughput;
+                ++c.samples;
+                return;
+            }
+        }
+
+        std::size_t best() const
+        {
+            std::size_t b = candidates.size() - 1;
+            for(std::size_t i = 0; i < candidates.size(); ++i) {
+                if(candidates[i].samples > 0 &&
+                   (candidates[b].samples == 0 || candidates[i].throughput > candidates[b].throughput)) {
+                    b = i;
+                }
+            }
+            return b;
+        }
+
+        std::vector<adaptive_candidate> candidates;
+        std::size_t calls = 0;
+    };
+
+    adaptive_concurrency() = default;
+
+    class_state& size_class(adaptive_kernel kernel, std::size_t size)
+    {
+        unsigned bit = 0;
+        while(size >> (bit + 1)) { ++bit; }
+        return classes[std::make_pair(kernel, bit)];
+    }
+
+    mutable std::mutex m;
+    std::atomic<bool> on_{false};
+    std::map<std::pair<adaptive_kernel, unsigned>, class_state> classes;
+};
+
+namespace internal
+{
+
+//================================================================================
+
+// One timed call of an adaptive algorithm. chunks() is what to pass to
+// for_each_chunk or reduce_chunks; done() reports the time since
+// construction. Calls that end early (e.g. equal finding a mismatch) or throw
+// shouldn't call done(), as their time says nothing about the throughput.
+class adaptive_call
+{
+public:
+
+    adaptive_call(adaptive_kernel kernel, std::size_t size)
+        : kernel(kernel), size(size),
+          chosen(adaptive_concurrency::instance().choose(kernel, size))
+    {
+        if(chosen) { start = std::chrono::steady_clock::now(); }
+    }
+
+    std::size_t chunks() const { return chosen ? chosen : chunk_count(size); }
+
+    void done() const
+    {
+        if(!chosen) { return; }
+        adaptive_concurrency::instance().record(kernel, size, chosen,
+            std::chrono::steady_clock::now() - start);
+    }
+
+private:
+
+    adaptive_kernel kernel;
+    std::size_t size;
+    std::size_t chosen;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // end namespace internal
+} // end namespace parallel
+} // end namespace experimental
@@ -0,0 +1,486 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "contiguous_iterator.hpp"
+#include "count.hpp"
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "search.hpp"
+#include "thread_pool.hpp"
+
+// Algorithms over neighbouring pairs of elements:
+//
+//     using namespace experimental::parallel;
+//     bool sorted = is_sorted(par, v.begin(), v.end());
+//     auto dup = adjacent_find(par, v.begin(), v.end());
+//     adjacent_difference(par, v.begin(), v.end(), d.begin());
+//
+// The parallel versions chunk the n - 1 pairs rather than the elements, so
+// the chunk owning pair i reads elements i and i + 1 and the pair made of one
+// chunk's last element and the next chunk's first is checked like any other.
+// adjacent_find and is_sorted_until report the lowest position through the
+// same early exit as search (see search.hpp).
+//
+// Under par_vec, arithmetic values in contiguous memory compared with the
+// standard comparison function objects are checked a block at a time: the
+// block and the same block shifted by one element are compared into a bit
+// mask without branches, a loop the compiler vectorizes.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+// Pairs compared at once by the vectorized matcher.
+constexpr std::size_t adjacent_block_width = 32;
+
+// is_sorted_until looks for the first pair that is out of order, i.e. the
+// pair (a, b) with comp(b, a).
+template <typename Compare>
+struct swapped_arguments
+{
+    Compare comp;
+
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const { return comp(b, a); }
+};
+
+// Comparisons that are cheap and free of side effects, so it's fine to
+// evaluate them for a whole block without stopping at the first match.
+template <typename Predicate>
+struct is_plain_comparison
+    : std::integral_constant<bool, false>
+{ };
+
+template <typename T>
+struct is_plain_comparison<std::equal_to<T>>
+    : std::integral_constant<bool, true>
+{ };
+
+template <typename T>
+struct is_plain_comparison<std::not_equal_to<T>>
+    : std::integral_constant<bool, true>
+{ };
+
+template <typename T>
+struct is_plain_comparison<std::less<T>>
+    : std::integral_constant<bool, true>
+{ };
+
+template <typename T>
+struct is_plain_comparison<std::greater<T>>
+    : std::integral_constant<bool, true>
+{ };
+
+template <typename Compare>
+struct is_plain_comparison<swapped_arguments<Compare>>
+    : is_plain_comparison<Compare>
+{ };
+
+template <typename Iterator, typename Predicate>
+constexpr bool is_vector_adjacent_v =
+    is_contiguous_iterator_v<Iterator> &&
+    std::is_arithmetic<typename std::iterator_traits<Iterator>::value_type>::value &&
+    is_plain_comparison<Predicate>::value;
+
+//================================================================================
+
+// Matchers in the sense of search.hpp over the pair positions: position j
+// matches if pred(begin[j], begin[j + 1]).
+
+template <typename RandomIt, typename BinaryPredicate>
+class adjacent_matcher
+{
+public:
+
+    adjacent_matcher(RandomIt begin, BinaryPredicate pred)
+        : begin(begin), pred(pred)
+    { }
+
+    std::size_t operator()(std::size_t first, std::size_t last) const
+    {
+        for(auto j = first; j != last; ++j) {
+            if(pred(begin[j], begin[j + 1])) { return j; }
+        }
+        return last;
+    }
+
+private:
+
+    RandomIt begin;
+    BinaryPredicate pred;
+};
+
+template <typename ContiguousIt, typename BinaryPredicate>
+class vector_adjacent_matcher
+{
+public:
+
+    vector_adjacent_matcher(ContiguousIt begin, BinaryPredicate pred)
+        : data(to_pointer(begin)), pred(pred)
+    { }
+
+    std::size_t operator()(std::size_t first, std::size_t last) const
+    {
+        auto pos = first;
+        for(; last - pos >= adjacent_block_width; pos += adjacent_block_width) {
+            const auto* current = data + pos;
+            const auto* next = current + 1;
+            std::uint32_t mask = 0;
+            for(std::size_t j = 0; j < adjacent_block_width; ++j) {
+                mask |= std::uint32_t(pred(current[j], next[j])) << j;
+            }
+            if(mask != 0) { return pos + lowest_set_bit(mask); }
+        }
+        for(; pos != last; ++pos) {
+            if(pred(data[pos], data[pos + 1])) { return pos; }
+        }
+        return last;
+    }
+
+private:
+
+    decltype(to_pointer(std::declval<ContiguousIt>())) data;
+    BinaryPredicate pred;
+};
+
+template <typename Policy, typename RandomIt, typename BinaryPredicate>
+adjacent_matcher<RandomIt, BinaryPredicate> make_adjacent_matcher(
+    Policy, RandomIt begin, BinaryPredicate pred
+)
+{
+    return { begin, pred };
+}
+
+template <typename RandomIt, typename BinaryPredicate>
+vector_adjacent_matcher<RandomIt, BinaryPredicate> make_adjacent_matcher(
+    parallel_vector_execution_policy, RandomIt begin, BinaryPredicate pred,
+    typename std::enable_if<is_vector_adjacent_v<RandomIt, BinaryPredicate>>::type* = 0
+)
+{
+    return { begin, pred };
+}
+
+//================================================================================
+//===============================adjacent_find====================================
+//================================================================================
+
+template <typename ForwardIt, typename BinaryPredicate>
+ForwardIt adjacent_find_impl(
+    sequential_execution_policy, ForwardIt begin, ForwardIt end, BinaryPredicate pred
+)
+{
+    return std::adjacent_find(begin, end, pred);
+}
+
+template <typename Policy, typename RandomIt, typename BinaryPredicate>
+RandomIt adjacent_find_random_access(
+    Policy policy, RandomIt begin, RandomIt end, BinaryPredicate pred
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if(size < 2) { return end; }
+
+    const auto pairs = size - 1;
+    const auto at = first_match(make_adjacent_matcher(policy, begin, pred), pairs);
+    return (at == pairs) ? end : begin + at;
+}
+
+template <typename ForwardIt, typename BinaryPredicate>
+ForwardIt adjacent_find_impl(
+    parallel_execution_policy pep, ForwardIt begin, ForwardIt end, BinaryPredicate pred,
+    enable_if_random<ForwardIt>* = 0
+)
+{
+    return adjacent_find_random_access(pep, begin, end, pred);
+}
+
+template <typename ForwardIt, typename BinaryPredicate>
+ForwardIt adjacent_find_impl(
+    parallel_execution_policy, ForwardIt begin, ForwardIt end, BinaryPredicate pred,
+    enable_if_not_random<ForwardIt>* = 0
+)
+{
+    return adjacent_find_impl(seq, begin, end, pred);
+}
+
+template <typename ForwardIt, typename BinaryPredicate>
+ForwardIt adjacent_find_impl(
+    parallel_vector_execution_policy pvep, ForwardIt begin, ForwardIt end,
+    BinaryPredicate pred, enable_if_random<ForwardIt>* = 0
+)
+{
+    return adjacent_find_random_access(pvep, begin, end, pred);
+}
+
+template <typename ForwardIt, typename BinaryPredicate>
+ForwardIt adjacent_find_impl(
+    parallel_vector_execution_policy, ForwardIt begin, ForwardIt end,
+    BinaryPredicate pred, enable_if_not_random<ForwardIt>* = 0
+)
+{
+    return adjacent_find_impl(seq, begin, end, pred);
+}
+
+//================================================================================
+
+template <typename Policy, typename ForwardIt, typename Compare>
+ForwardIt is_sorted_until_impl(
+    Policy policy, ForwardIt begin, ForwardIt end, Compare comp
+)
+{
+    auto unordered = adjacent_find_impl(policy, begin, end,
+                                        swapped_arguments<Compare>{comp});
+    return (unordered == end) ? end : std::next(unordered);
+}
+
+//================================================================================
+//============================adjacent_difference=================================
+//================================================================================
+
+template <typename InputIt, typename OutputIt, typename BinaryOp>
+OutputIt adjacent_difference_impl(
+    sequential_execution_policy, InputIt begin, InputIt end, OutputIt out, BinaryOp op
+)
+{
+    return std::adjacent_difference(begin, end, out, op);
+}
+
+// Like std::adjacent_difference, every chunk carries the previous input value
+// along rather than reading it again, so the output may be the input range
+// itself. The values preceding every chunk are copied out before any chunk
+// starts writing.
+template <typename InputIt, typename OutputIt, typename BinaryOp>
+OutputIt adjacent_difference_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, OutputIt out, BinaryOp op,
+    typename std::enable_if<
+        std::is_same<
+            typename std::iterator_traits<InputIt>::iterator_category,
+            std::random_access_iterator_tag
+        >::value &&
+        std::is_same<
+            typename std::iterator_traits<OutputIt>::iterator_category,
+            std::random_access_iterator_tag
+        >::value
+    >::type* = 0
+)
+{
+    using value_type = typename std::iterator_traits<InputIt>::value_type;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if(size == 0) { return out; }
+
+    // Chunks cover the elements [1, size).
+    const auto rest = size - 1;
+    const auto n = chunk_count(rest);
+    std::vector<value_type> previous;
+    previous.reserve(n);
+    for(std::size_t i = 0; i < n; ++i) { previous.push_back(begin[chunk_begin(i, n, rest)]); }
+    *out = begin[0];
+
+    for_each_chunk(rest,
+        [begin, out, &op, &previous](std::size_t i, std::size_t first, std::size_t last) {
+            value_type prev = std::move(previous[i]);
+            for(auto j = first + 1; j != last + 1; ++j) {
+                value_type current = begin[j];
+                out[j] = op(current, std::move(prev));
+                prev = std::move(current);
+            }
+        });
+
+    return out + size;
+}
+
+template <typename InputIt, typename OutputIt, typename BinaryOp>
+OutputIt adjacent_difference_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, OutputIt out, BinaryOp op,
+    typename std::enable_if<
+        !std::is_same<
+            typename std::iterator_traits<InputIt>::iterator_category,
+            std::random_access_iterator_tag
+        >::value ||
+        !std::is_same<
+            typename std::iterator_traits<OutputIt>::iterator_category,
+            std::random_access_iterator_tag
+        >::value
+    >::type* = 0
+)
+{
+    return adjacent_difference_impl(seq, begin, end, out, op);
+}
+
+template <typename InputIt, typename OutputIt, typename BinaryOp>
+OutputIt adjacent_difference_impl(
+    parallel_vector_execution_policy, InputIt begin, InputIt end, OutputIt out, BinaryOp op
+)
+{
+    return adjacent_difference_impl(par, begin, end, out, op);
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename ForwardIt, typename BinaryPredicate>
+ForwardIt adjacent_find(
+    ExecutionPolicy&& policy, ForwardIt begin, ForwardIt end, BinaryPredicate pred,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::adjacent_find_impl(policy, begin, end, pred);
+}
+
+template <typename ForwardIt, typename BinaryPredicate>
+ForwardIt adjacent_find(
+    execution_policy policy, ForwardIt begin, ForwardIt end, BinaryPredicate pred
+)
+{
+    auto f = [begin, end, pred](auto policy)
+             { return internal::adjacent_find_impl(policy, begin, end, pred); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt>
+ForwardIt adjacent_find(
+    ExecutionPolicy&& policy, ForwardIt begin, ForwardIt end,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::adjacent_find_impl(policy, begin, end, std::equal_to<>{});
+}
+
+template <typename ForwardIt>
+ForwardIt adjacent_find(
+    execution_policy policy, ForwardIt begin, ForwardIt end
+)
+{
+    return adjacent_find(policy, begin, end, std::equal_to<>{});
+}
+
+//--------------------------------------------------------------------------------
+
+template <typename ExecutionPolicy, typename ForwardIt, typename Compare>
+ForwardIt is_sorted_until(
+    ExecutionPolicy&& policy, ForwardIt begin, ForwardIt end, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::is_sorted_until_impl(policy, begin, end, comp);
+}
+
+template <typename ForwardIt, typename Compare>
+ForwardIt is_sorted_until(
+    execution_policy policy, ForwardIt begin, ForwardIt end, Compare comp
+)
+{
+    auto f = [begin, end, comp](auto policy)
+             { return internal::is_sorted_until_impl(policy, begin, end, comp); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt>
+ForwardIt is_sorted_until(
+    ExecutionPolicy&& policy, ForwardIt begin, ForwardIt end,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::is_sorted_until_impl(policy, begin, end, std::less<>{});
+}
+
+template <typename ForwardIt>
+ForwardIt is_sorted_until(
+    execution_policy policy, ForwardIt begin, ForwardIt end
+)
+{
+    return is_sorted_until(policy, begin, end, std::less<>{});
+}
+
+//--------------------------------------------------------------------------------
+
+template <typename ExecutionPolicy, typename ForwardIt, typename Compare>
+bool is_sorted(
+    ExecutionPolicy&& policy, ForwardIt begin, ForwardIt end, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::is_sorted_until_impl(policy, begin, end, comp) == end;
+}
+
+template <typename ForwardIt, typename Compare>
+bool is_sorted(
+    execution_policy policy, ForwardIt begin, ForwardIt end, Compare comp
+)
+{
+    return is_sorted_until(policy, begin, end, comp) == end;
+}
+
+template <typename ExecutionPolicy, typename ForwardIt>
+bool is_sorted(
+    ExecutionPolicy&& policy, ForwardIt begin, ForwardIt end,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::is_sorted_until_impl(policy, begin, end, std::less<>{}) == end;
+}
+
+template <typename ForwardIt>
+bool is_sorted(
+    execution_policy policy, ForwardIt begin, ForwardIt end
+)
+{
+    return is_sorted_until(policy, begin, end, std::less<>{}) == end;
+}
+
+//--------------------------------------------------------------------------------
+
+template <typename ExecutionPolicy, typename InputIt, typename OutputIt, typename BinaryOp>
+OutputIt adjacent_difference(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, OutputIt out, BinaryOp op,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::adjacent_difference_impl(policy, begin, end, out, op);
+}
+
+template <typename InputIt, typename OutputIt, typename BinaryOp>
+OutputIt adjacent_difference(
+    execution_policy policy, InputIt begin, InputIt end, OutputIt out, BinaryOp op
+)
+{
+    auto f = [begin, end, out, op](auto policy)
+             { return internal::adjacent_difference_impl(policy, begin, end, out, op); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename InputIt, typename OutputIt>
+OutputIt adjacent_difference(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, OutputIt out,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::adjacent_difference_impl(policy, begin, end, out, std::minus<>{});
+}
+
+template <typename InputIt, typename OutputIt>
+OutputIt adjacent_difference(
+    execution_policy policy, InputIt begin, InputIt end, OutputIt out
+)
+{
+    return adjacent_difference(policy, begin, end, out, std::minus<>{});
+}
+
+} // end namespace parallel
+} // end namespace experimental
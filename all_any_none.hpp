@@ -2,16 +2,18 @@
 
 #include <algorithm>
 #include <atomic>
-#include <future>
 #include <iterator>
 #include <thread>
 #include <type_traits>
 #include <typeinfo>
 #include <vector>
 
+#include "bits.hpp"
 #include "dispatch.hpp"
 #include "execution_policy.hpp"
 #include "hardware_conc.hpp"
+#include "streaming.hpp"
+#include "thread_pool.hpp"
 
 namespace experimental
 {
@@ -54,47 +56,51 @@ bool none_of_impl(
 template <typename InputIt, typename Predicate, bool InitialResult>
 bool any_all_none_impl(
     parallel_execution_policy, InputIt begin, InputIt end,
-    std::random_access_iterator_tag, Predicate pred 
+    std::random_access_iterator_tag, Predicate pred,
+    enable_if_not_bit_test<InputIt, Predicate>* = 0
 )
 {
-    const static unsigned hc = 2 * get_hardware_concurrency_or_default();
-    const auto size = std::distance(begin, end);
-    const auto chunk_size = static_cast<std::size_t>(size) / hc;
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
     const bool initial = InitialResult;
-    std::vector<std::future<void>> tasks;
 
     std::atomic<bool> result{InitialResult};
     std::atomic<bool> continue_search{true};
-    tasks.reserve(hc);
     
-    for(auto i = 0U; i < hc; ++i) {
-        const unsigned i_chunk = i * chunk_size;
-        const unsigned next_i_chunk = i_chunk + chunk_size; 
-        tasks.emplace_back(
-            std::async(
-                std::launch::async,
-                [begin, i_chunk, next_i_chunk, pred, &result, &continue_search] { 
-                auto begin_chunk = begin + i_chunk;
-                auto end_chunk = begin + next_i_chunk;
-                while(begin_chunk != end_chunk && 
-                      continue_search.load(std::memory_order_relaxed)
-                ) 
-                {
-                    if(pred(*begin_chunk) != initial) { 
-                        result.store(!InitialResult, std::memory_order_relaxed); 
-                        continue_search.store(false, std::memory_order_relaxed);
-                        return; 
-                    }
-                    ++begin_chunk; 
-                }
-            })
-        );
-    }
-
-    for(auto&& task : tasks) { task.get(); }
+    for_each_chunk(size,
+        [begin, pred, &result, &continue_search](std::size_t, std::size_t first, std::size_t last) { 
+        auto begin_chunk = begin + first;
+        auto end_chunk = begin + last;
+        chunk_hint(begin_chunk, end_chunk);
+        while(begin_chunk != end_chunk && 
+              continue_search.load(std::memory_order_relaxed)
+        ) 
+        {
+            if(pred(*begin_chunk) != initial) { 
+                result.store(!InitialResult, std::memory_order_relaxed); 
+                continue_search.store(false, std::memory_order_relaxed);
+                return; 
+            }
+            ++begin_chunk; 
+        }
+    });
+
     return result;
 }
 
+// Bit-packed ranges tested for set or clear bits compare whole words, see
+// bits.hpp. The result is decided by any bit that the predicate doesn't map
+// to InitialResult.
+template <typename InputIt, typename Predicate, bool InitialResult>
+bool any_all_none_impl(
+    parallel_execution_policy, InputIt begin, InputIt end,
+    std::random_access_iterator_tag, Predicate,
+    enable_if_bit_test<InputIt, Predicate>* = 0
+)
+{
+    const bool decider = bit_predicate<Predicate>::satisfied_by != InitialResult;
+    return find_bit(begin, end, decider) ? !InitialResult : InitialResult;
+}
+
 //--------------------------------------------------------------------------------
 
 template <typename InputIt, typename Predicate>
@@ -130,29 +136,42 @@ bool none_of_impl(
 
 //--------------------------------------------------------------------------------
 
-// Parallel execution policy but non-random access iterators, just
-// forward this to the normal (sequential) std::algorithm functions.
+// Parallel execution policy but non-random access iterators: the elements
+// are streamed to the pool in blocks (see streaming.hpp), and the stream is
+// stopped as soon as any block finds an element that decides the result.
+
+template <typename InputIt, typename Predicate>
+bool stream_find_decider(InputIt begin, InputIt end, Predicate pred, bool decider)
+{
+    std::atomic<bool> found{false};
+    stream_for_each(begin, end, [&found, &pred, decider](auto&& x) {
+        if(static_cast<bool>(pred(x)) != decider) { return true; }
+        found.store(true, std::memory_order_relaxed);
+        return false;
+    });
+    return found;
+}
 
 template <typename InputIt, typename IterTag, typename Predicate>
 bool any_of_impl(
-    parallel_execution_policy pep, InputIt begin, InputIt end,
+    parallel_execution_policy, InputIt begin, InputIt end,
     IterTag, Predicate pred 
 )
-{ return std::any_of(begin, end, pred); }
+{ return stream_find_decider(begin, end, pred, true); }
 
 template <typename InputIt, typename IterTag, typename Predicate>
 bool all_of_impl(
-    parallel_execution_policy pep, InputIt begin, InputIt end,
-    std::random_access_iterator_tag tag, Predicate pred 
+    parallel_execution_policy, InputIt begin, InputIt end,
+    IterTag, Predicate pred 
 )
-{ return std::all_of(begin, end, pred); }
+{ return !stream_find_decider(begin, end, pred, false); }
 
 template <typename InputIt, typename IterTag, typename Predicate>
 bool none_of_impl(
-    parallel_execution_policy pep, InputIt begin, InputIt end,
-    std::random_access_iterator_tag tag, Predicate pred 
+    parallel_execution_policy, InputIt begin, InputIt end,
+    IterTag, Predicate pred 
 )
-{ return std::none_of(begin, end, pred); }
+{ return !stream_find_decider(begin, end, pred, true); }
 
 //================================================================================
 //=====================Parallel Vector Execution Policy===========================
@@ -202,29 +221,29 @@ bool none_of_impl(
 
 //--------------------------------------------------------------------------------
 
-// Parallel Vector execution policy but non-random access iterators, just
-// forward this to the normal (sequential) std::algorithm functions.
+// Parallel Vector execution policy but non-random access iterators, these
+// are streamed exactly like the parallel versions.
 
 template <typename InputIt, typename IterTag, typename Predicate>
 bool any_of_impl(
-    parallel_vector_execution_policy pep, InputIt begin, InputIt end,
-    IterTag, Predicate pred 
+    parallel_vector_execution_policy, InputIt begin, InputIt end,
+    IterTag tag, Predicate pred 
 )
-{ return std::any_of(begin, end, pred); }
+{ return any_of_impl(par, begin, end, tag, pred); }
 
 template <typename InputIt, typename IterTag, typename Predicate>
 bool all_of_impl(
-    parallel_vector_execution_policy pep, InputIt begin, InputIt end,
-    std::random_access_iterator_tag tag, Predicate pred 
+    parallel_vector_execution_policy, InputIt begin, InputIt end,
+    IterTag tag, Predicate pred 
 )
-{ return std::all_of(begin, end, pred); }
+{ return all_of_impl(par, begin, end, tag, pred); }
 
 template <typename InputIt, typename IterTag, typename Predicate>
 bool none_of_impl(
-    parallel_vector_execution_policy pep, InputIt begin, InputIt end,
-    std::random_access_iterator_tag tag, Predicate pred 
+    parallel_vector_execution_policy, InputIt begin, InputIt end,
+    IterTag tag, Predicate pred 
 )
-{ return std::none_of(begin, end, pred); }
+{ return none_of_impl(par, begin, end, tag, pred); }
 
 //================================================================================
 //=============================Dispatch Functions=================================
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "iterator_operators.hpp"
+#include "thread_pool.hpp"
+
+// Bit-packed ranges: std::vector<bool>, and bit_span, a view of a bit mask
+// stored in an array of words:
+//
+//     using namespace experimental::parallel;
+//     std::vector<std::uint64_t> mask = ...;
+//     bit_span bits(mask.data(), 1000000);
+//     auto occupied = count(par, bits.begin(), bits.end(), true);
+//     auto any_free = any_of(par, bits.begin(), bits.end(), std::logical_not<>{});
+//
+// Going through the iterators of these costs a shift and a mask per bit. The
+// parallel count, and count_if, any_of, all_of and none_of with the predicate
+// bit_is_set (below) or its negation (std::logical_not), recognize
+// bit iterators and work on whole words instead: counting is a popcount per
+// word, and the searches compare whole words at a time. The range is split
+// across the workers on word boundaries, so no two chunks share a word.
+
+namespace experimental
+{
+namespace parallel
+{
+
+//================================================================================
+
+// Whether a bit is set: any_of(par, b, e, bit_is_set{}) is true if any of
+// the bits in [b, e) is set.
+struct bit_is_set
+{
+    template <typename Bit>
+    constexpr bool operator()(const Bit& bit) const noexcept
+    { return static_cast<bool>(bit); }
+};
+
+//================================================================================
+
+template <typename Word>
+class bit_iterator;
+
+// Proxy for a single bit of a mutable word.
+template <typename Word>
+class bit_reference
+{
+public:
+
+    bit_reference(Word* word, unsigned offset)
+        : word(word), mask(Word(1) << offset)
+    { }
+
+    operator bool() const noexcept { return (*word & mask) != 0; }
+
+    bit_reference& operator=(bool b) noexcept
+    {
+        if(b) { *word |= mask; } else { *word &= ~mask; }
+        return *this;
+    }
+
+    bit_reference& operator=(const bit_reference& other) noexcept
+    { return *this = static_cast<bool>(other); }
+
+    void flip() noexcept { *word ^= mask; }
+
+private:
+
+    Word* word;
+    Word mask;
+};
+
+template <typename Word>
+class bit_iterator
+    : public internal::random_access_operators<bit_iterator<Word>, std::ptrdiff_t>
+{
+public:
+
+    static constexpr unsigned word_bits = CHAR_BIT * sizeof(Word);
+
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = bool;
+    using reference =
+        typename std::conditional<std::is_const<Word>::value, bool, bit_reference<Word>>::type;
+    using pointer = void;
+
+    bit_iterator() = default;
+
+    bit_iterator(Word* word, unsigned offset)
+        : word(word), offset(offset)
+    { }
+
+    // Mutable to const.
+    template <typename Other,
+              typename = typename std::enable_if<std::is_same<const Other, Word>::value>::type>
+    bit_iterator(const bit_iterator<Other>& other)
+        : word(other.word), offset(other.offset)
+    { }
+
+    reference operator*() const { return deref(std::is_const<Word>{}); }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    void advance(difference_type n)
+    {
+        const auto bit = static_cast<difference_type>(offset) + n;
+        auto words = bit / static_cast<difference_type>(word_bits);
+        if(bit % static_cast<difference_type>(word_bits) < 0) { --words; }
+        word += words;
+        offset = static_cast<unsigned>(bit - words * static_cast<difference_type>(word_bits));
+    }
+
+    difference_type distance_to(const bit_iterator& other) const
+    {
+        return (other.word - word) * static_cast<difference_type>(word_bits)
+             + static_cast<difference_type>(other.offset) - static_cast<difference_type>(offset);
+    }
+
+    bool equal(const bit_iterator& other) const
+    { return word == other.word && offset == other.offset; }
+
+private:
+
+    template <typename Other>
+    friend class bit_iterator;
+    template <typename Iterator>
+    friend struct bit_iterator_traits;
+
+    bool deref(std::true_type) const { return (*word >> offset) & 1; }
+    bit_reference<Word> deref(std::false_type) const { return { word, offset }; }
+
+    Word* word = nullptr;
+    unsigned offset = 0;
+};
+
+// size bits, starting at bit offset of words[0]. Word can be const.
+template <typename Word>
+class basic_bit_span
+{
+public:
+
+    using iterator = bit_iterator<Word>;
+
+    basic_bit_span(Word* words, std::size_t size, std::size_t offset = 0)
+        : first(words + offset / iterator::word_bits,
+                static_cast<unsigned>(offset % iterator::word_bits)),
+          count(size)
+    { }
+
+    iterator begin() const { return first; }
+    iterator end() const { return first + static_cast<std::ptrdiff_t>(count); }
+
+    std::size_t size() const { return count; }
+
+private:
+
+    iterator first;
+    std::size_t count;
+};
+
+using bit_span = basic_bit_span<std::uint64_t>;
+using const_bit_span = basic_bit_span<const std::uint64_t>;
+
+//================================================================================
+
+// How to get at the words behind a bit iterator: word(it) is the word it
+// points into and offset(it) the index of its bit within that word.
+template <typename Iterator>
+struct bit_iterator_traits
+{
+    static constexpr bool is_bit_iterator = false;
+};
+
+template <typename Word>
+struct bit_iterator_traits<bit_iterator<Word>>
+{
+    static constexpr bool is_bit_iterator = true;
+
+    using word_type = std::remove_const_t<Word>;
+
+    static const word_type* word(const bit_iterator<Word>& it) { return it.word; }
+    static unsigned offset(const bit_iterator<Word>& it) { return it.offset; }
+};
+
+#if defined(__GLIBCXX__)
+// std::vector<bool>, through the libstdc++ iterators' members.
+template <>
+struct bit_iterator_traits<std::_Bit_iterator>
+{
+    static constexpr bool is_bit_iterator = true;
+
+    using word_type = std::_Bit_type;
+
+    static const word_type* word(const std::_Bit_iterator& it) { return it._M_p; }
+    static unsigned offset(const std::_Bit_iterator& it) { return it._M_offset; }
+};
+
+template <>
+struct bit_iterator_traits<std::_Bit_const_iterator>
+{
+    static constexpr bool is_bit_iterator = true;
+
+    using word_type = std::_Bit_type;
+
+    static const word_type* word(const std::_Bit_const_iterator& it) { return it._M_p; }
+    static unsigned offset(const std::_Bit_const_iterator& it) { return it._M_offset; }
+};
+#endif
+
+template <typename Iterator>
+constexpr bool is_bit_iterator_v = bit_iterator_traits<Iterator>::is_bit_iterator;
+
+namespace internal
+{
+
+//================================================================================
+
+// The bit a predicate is true for, when it is known to test a bool for being
+// true (bit_is_set) or false (std::logical_not).
+template <typename Predicate>
+struct bit_predicate
+{
+    static constexpr bool is_bit_test = false;
+};
+
+template <>
+struct bit_predicate<bit_is_set>
+{
+    static constexpr bool is_bit_test = true;
+    static constexpr bool satisfied_by = true;
+};
+
+template <>
+struct bit_predicate<std::logical_not<bool>>
+{
+    static constexpr bool is_bit_test = true;
+    static constexpr bool satisfied_by = false;
+};
+
+template <>
+struct bit_predicate<std::logical_not<>>
+{
+    static constexpr bool is_bit_test = true;
+    static constexpr bool satisfied_by = false;
+};
+
+template <typename Iterator>
+using enable_if_bit_iterator =
+    typename std::enable_if<is_bit_iterator_v<Iterator>>::type;
+
+template <typename Iterator>
+using enable_if_not_bit_iterator =
+    typename std::enable_if<!is_bit_iterator_v<Iterator>>::type;
+
+template <typename Iterator, typename Predicate>
+constexpr bool is_bit_test_v =
+    is_bit_iterator_v<Iterator> && bit_predicate<Predicate>::is_bit_test;
+
+template <typename Iterator, typename Predicate>
+using enable_if_bit_test =
+    typename std::enable_if<is_bit_test_v<Iterator, Predicate>>::type;
+
+template <typename Iterator, typename Predicate>
+using enable_if_not_bit_test =
+    typename std::enable_if<!is_bit_test_v<Iterator, Predicate>>::type;
+
+//================================================================================
+
+template <typename Word>
+unsigned popcount(Word w) noexcept
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_popcountll(static_cast<unsigned long long>(w)));
+#else
+    return static_cast<unsigned>(std::bitset<CHAR_BIT * sizeof(Word)>(w).count());
+#endif
+}
+
+// Bits [first, last) of a bit range, numbered from bit 0 of words[0].
+template <typename Word>
+class word_range
+{
+public:
+
+    static constexpr std::size_t word_bits = CHAR_BIT * sizeof(Word);
+
+    template <typename BitIt>
+    word_range(BitIt begin, BitIt end)
+        : words(bit_iterator_traits<BitIt>::word(begin)),
+          first(bit_iterator_traits<BitIt>::offset(begin)),
+          last(first + static_cast<std::size_t>(end - begin))
+    { }
+
+    // Number of words the range touches.
+    std::size_t size() const
+    { return first == last ? 0 : (last - 1) / word_bits + 1; }
+
+    // Word i with the bits outside the range masked off (set to fill).
+    Word word(std::size_t i, bool fill) const
+    {
+        const Word all = ~Word(0);
+        Word keep = all;
+        if(i == 0) { keep &= all << first; }
+        if(i == (last - 1) / word_bits) {
+            const auto top = last - i * word_bits;
+            if(top < word_bits) { keep &= ~(all << top); }
+        }
+        const Word w = words[i];
+        return fill ? (w | ~keep) : (w & keep);
+    }
+
+    // Number of set bits in words [wfirst, wlast).
+    std::size_t count(std::size_t wfirst, std::size_t wlast) const
+    {
+        // Only the first and last words of the range need masking.
+        std::size_t n = 0;
+        auto i = wfirst;
+        if(i == 0 && i < wlast) { n += popcount(word(i++, false)); }
+        for(const auto inner_last = std::min(wlast, size() - 1); i < inner_last; ++i) {
+            n += popcount(words[i]);
+        }
+        if(i < wlast) { n += popcount(word(i, false)); }
+        return n;
+    }
+
+private:
+
+    const Word* words;
+    std::size_t first;
+    std::size_t last;
+};
+
+// Number of set bits in [begin, end), counted a word at a time by chunks of
+// whole words.
+template <typename BitIt>
+std::size_t count_set_bits(BitIt begin, BitIt end)
+{
+    using word_type = typename bit_iterator_traits<BitIt>::word_type;
+
+    const word_range<word_type> range(begin, end);
+    return reduce_chunks(range.size(), std::size_t(0),
+        [&range](std::size_t first, std::size_t last) { return range.count(first, last); },
+        std::plus<>{});
+}
+
+// Whether any bit in [begin, end) equals value. Chunks of whole words look at
+// a block of words at a time, and stop once any chunk has found one.
+template <typename BitIt>
+bool find_bit(BitIt begin, BitIt end, bool value)
+{
+    using word_type = typename bit_iterator_traits<BitIt>::word_type;
+    constexpr std::size_t block_words = 64;
+
+    const word_range<word_type> range(begin, end);
+    std::atomic<bool> found{false};
+
+    for_each_chunk(range.size(),
+        [&range, &found, value](std::size_t, std::size_t first, std::size_t last) {
+            // Words are complemented when looking for a clear bit, and the
+            // bits outside the range are filled so that they never match.
+            const word_type flip = value ? word_type(0) : ~word_type(0);
+            while(first != last && !found.load(std::memory_order_relaxed)) {
+                const auto block_end = std::min(last, first + block_words);
+                word_type any = 0;
+                for(; first != block_end; ++first) { any |= range.word(first, !value) ^ flip; }
+                if(any) {
+                    found.store(true, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        });
+
+    return found;
+}
+
+} // end namespace internal
+} // end namespace parallel
+} // end namespace experimental
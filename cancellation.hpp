@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace experimental
+{
+namespace parallel
+{
+
+//================================================================================
+
+// Status returned by the cancellable overloads of the algorithms.
+enum class completion_status
+    : std::uint8_t
+{ completed, cancelled };
+
+// Result of a cancellable algorithm that produces a value. If the algorithm
+// was cancelled, value only reflects the elements that were visited before
+// the workers noticed the stop request.
+template <typename T>
+struct cancellable_result
+{
+    T value;
+    completion_status status;
+
+    bool cancelled() const noexcept
+    { return status == completion_status::cancelled; }
+};
+
+//================================================================================
+
+class cancellation_token;
+
+// Owner side of a cancellation flag. Any number of tokens can be handed
+// out, and all of them observe a call to request_cancellation().
+class cancellation_source
+{
+public:
+
+    cancellation_source()
+        : state(std::make_shared<std::atomic<bool>>(false))
+    { }
+
+    cancellation_token token() const noexcept;
+
+    void request_cancellation() noexcept
+    {
+        state->store(true, std::memory_order_relaxed);
+    }
+
+    bool cancellation_requested() const noexcept
+    {
+        return state->load(std::memory_order_relaxed);
+    }
+
+private:
+
+    std::shared_ptr<std::atomic<bool>> state;
+};
+
+//================================================================================
+
+// Observer side: polled by workers at block granularity. A token can be tied
+// to a cancellation_source, a deadline, or both. A default constructed token
+// is never cancelled.
+class cancellation_token
+{
+public:
+
+    using clock = std::chrono::steady_clock;
+
+    cancellation_token() = default;
+
+    explicit cancellation_token(clock::time_point deadline)
+        : deadline(deadline), has_deadline(true)
+    { }
+
+    cancellation_token with_deadline(clock::time_point d) const noexcept
+    {
+        cancellation_token t = *this;
+        if(!t.has_deadline || d < t.deadline) { t.deadline = d; }
+        t.has_deadline = true;
+        return t;
+    }
+
+    cancellation_token with_timeout(clock::duration timeout) const noexcept
+    {
+        return with_deadline(clock::now() + timeout);
+    }
+
+    bool stop_requested() const noexcept
+    {
+        if(state && state->load(std::memory_order_relaxed)) { return true; }
+        return has_deadline && clock::now() >= deadline;
+    }
+
+private:
+
+    friend class cancellation_source;
+
+    explicit cancellation_token(std::shared_ptr<std::atomic<bool>> s)
+        : state(std::move(s))
+    { }
+
+    std::shared_ptr<std::atomic<bool>> state;
+    clock::time_point deadline{};
+    bool has_deadline = false;
+};
+
+inline cancellation_token cancellation_source::token() const noexcept
+{
+    return cancellation_token{state};
+}
+
+//================================================================================
+
+namespace internal
+{
+
+// Number of elements a worker processes between two polls of the token.
+// Polling a deadline reads the clock, so this shouldn't be too small.
+constexpr std::size_t cancellation_block_size = 4096;
+
+// Applies f to every element in [begin, end), polling the token at the start
+// of every block. Returns false if the token stopped the loop early.
+template <typename InputIt, typename Func>
+bool cancellable_for_each(
+    InputIt begin, InputIt end, const cancellation_token& token, Func&& f
+)
+{
+    std::size_t in_block = 0;
+    for(; begin != end; ++begin) {
+        if(in_block == 0 && token.stop_requested()) { return false; }
+        f(*begin);
+        if(++in_block == cancellation_block_size) { in_block = 0; }
+    }
+    return true;
+}
+
+} // end namespace internal
+
+} // end namespace parallel
+} // end namespace experimental
@@ -1,16 +1,104 @@
 #include "execution_policy.hpp"
+#include "adaptive.hpp"
+#include "bits.hpp"
+#include "cancellation.hpp"
 #include "all_any_none.hpp"
 #include "equal.hpp"
 #include "for_each.hpp"
 #include "count.hpp"
+#include "pipeline.hpp"
+#include "scan.hpp"
+#include "histogram.hpp"
+#include "mapped_file.hpp"
+#include "zip_iterator.hpp"
+#include "segmented.hpp"
+#include "random.hpp"
+#include "reduce.hpp"
+#include "selection.hpp"
+#include "search.hpp"
+#include "adjacent.hpp"
+#include "coroutine.hpp"
+#include "task_graph.hpp"
+#include "uninitialized.hpp"
+#include "for_loop.hpp"
+#include "tile.hpp"
+#include "shared_memory.hpp"
+#include "merge.hpp"
+#include "unique.hpp"
 
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <list>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
 // Just a test file so I can check that everything at least compiles,
 // and the most basic of basic tests give the correct results.
 
 namespace exp_par = experimental::parallel;
 
+// Counts heap allocations, to check that the parallel calls don't make any.
+// (GCC warns about freeing memory from operator new once these are inlined,
+// not knowing that the replacement gets it from malloc.)
+std::atomic<std::size_t> allocations{0};
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if(void* p = std::malloc(size ? size : 1)) { return p; }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Single-pass source of the integers from i that fails on reaching limit.
+struct failing_input
+{
+    using iterator_category = std::input_iterator_tag;
+    using value_type = int;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const int*;
+    using reference = int;
+
+    int i;
+    int limit;
+
+    int operator*() const { return i; }
+    failing_input& operator++()
+    {
+        if(++i == limit) { throw std::runtime_error("source failed"); }
+        return *this;
+    }
+    bool operator==(const failing_input& other) const { return i == other.i; }
+    bool operator!=(const failing_input& other) const { return i != other.i; }
+};
+
+#if defined(__cpp_impl_coroutine)
+exp_par::coro::task<long> count_evens(const std::vector<int>& v)
+{
+    co_return co_await exp_par::coro::count_if(exp_par::par, v.begin(), v.end(),
+                                               [](int i) { return i % 2 == 0; });
+}
+#endif
+
 int main()
 {
     exp_par::execution_policy p = exp_par::seq;
@@ -43,4 +131,247 @@ int main()
 
     num = exp_par::count_if(p, v.begin(), v.end(), [](int i) { return i % 2 == 0; });
     std::cout << num << '\n';
+
+    exp_par::cancellation_source source;
+    auto cr = exp_par::count_if(p, v.begin(), v.end(), 
+        [](int i) { return i % 2 == 0; }, source.token().with_timeout(std::chrono::hours(1)));
+    std::cout << cr.value << ' ' << std::boolalpha << cr.cancelled() << '\n';
+
+    source.request_cancellation();
+    auto status = exp_par::for_each(p, v.begin(), v.end(), [](int) { }, source.token());
+    std::cout << std::boolalpha << (status == exp_par::completion_status::cancelled) << '\n';
+
+    namespace views = exp_par::views;
+    num = exp_par::count_if(p, v | views::transform([](int i) { return i / 2; })
+                                 | views::filter([](int i) { return i % 2 == 0; }), 
+                            [](int i) { return i < 100; });
+    std::cout << num << '\n';
+
+    namespace query = exp_par::query;
+    auto batch = exp_par::scan(p, v.begin(), v.end(),
+        query::count_if([](int i) { return i % 2 == 0; }),
+        query::any_of([](int i) { return i == 5000; }),
+        query::all_of([](int i) { return i >= 0; }));
+    std::cout << std::get<0>(batch) << ' ' << std::get<1>(batch) << ' ' 
+              << std::get<2>(batch) << '\n';
+
+    auto hist = exp_par::histogram(p, v.begin(), v.end(), 10, [](int i) { return i % 10; });
+    std::cout << hist[0] << ' ' << hist[9] << '\n';
+
+    auto by_key = exp_par::count_by_key(p, v.begin(), v.end(), [](int i) { return i % 3; });
+    std::cout << by_key[0] << '\n';
+
+    // Nested calls share the pool rather than spawning threads of their own.
+    std::atomic<long> nested{0};
+    exp_par::for_each(p, t.begin(), t.begin() + 100, [&nested, &v](int) {
+        nested += exp_par::count_if(exp_par::par, v.begin(), v.end(), [](int i) { return i < 10; });
+    });
+    std::cout << nested << '\n';
+
+    {
+        std::ofstream out("compile_test_mapped.txt");
+        for(auto i = 0; i < 1000; ++i) { out << i << '\n'; }
+    }
+    {
+        exp_par::mapped_range file("compile_test_mapped.txt");
+        std::cout << exp_par::count(p, file.begin(), file.end(), '\n') << ' '
+                  << exp_par::any_of(p, file.begin(), file.end(), [](char c) { return c == 'x'; })
+                  << '\n';
+    }
+    std::remove("compile_test_mapped.txt");
+
+    // Single-pass input is streamed to the pool in blocks.
+    std::istringstream numbers("1 2 3 4 5 6 7 8 9 10");
+    std::cout << exp_par::count_if(p, std::istream_iterator<int>(numbers),
+                                   std::istream_iterator<int>(),
+                                   [](int i) { return i % 2 == 0; }) << ' ';
+    std::list<int> l(1000, 1);
+    std::cout << exp_par::all_of(p, l.begin(), l.end(), [](int i) { return i == 1; }) << '\n';
+
+    // A source that throws midway stops the stream and waits for the blocks
+    // already handed out before the exception gets through.
+    std::atomic<long> streamed{0};
+    try {
+        exp_par::for_each(exp_par::par, failing_input{0, 50000}, failing_input{100000, 0},
+                          [&streamed](int i) { streamed += i; });
+    }
+    catch(const std::runtime_error& e) { std::cout << e.what() << '\n'; }
+
+    // Random data only depends on the seed and the position.
+    std::vector<double> r1(1000), r2(1000);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    exp_par::generate_random(exp_par::seq, r1.begin(), r1.end(), unit, 42);
+    exp_par::generate_random(p, r2.begin(), r2.end(), unit, 42);
+    std::cout << std::boolalpha << (r1 == r2) << '\n';
+
+    // par_deterministic sums don't depend on the number of threads.
+    p = exp_par::par_deterministic;
+    std::cout << exp_par::reduce(p, r1.begin(), r1.end(), 0.0) << ' '
+              << exp_par::compensated_sum(p, r1.begin(), r1.end(), 0.0) << '\n';
+
+    auto best = exp_par::top_k(p, v.begin(), v.end(), 3);
+    auto u = v;
+    exp_par::nth_element(p, u.begin(), u.begin() + 50000, u.end());
+    std::cout << best[0] << ' ' << best[2] << ' ' << u[50000] << '\n';
+    auto all = exp_par::top_k(p, best.begin(), best.end(), std::size_t(1) << 60);
+    exp_par::partial_sort(p, u.begin(), u.begin() + 40000, u.end());
+    std::cout << all.size() << ' ' << std::is_sorted(u.begin(), u.begin() + 40000) << ' '
+              << u[39999] << '\n';
+
+    std::string text(100000, '.');
+    const std::string word = "needle";
+    text.replace(49998, word.size(), word);
+    text.replace(90000, word.size(), word);
+    auto hit = exp_par::search(p, text.begin(), text.end(), word.begin(), word.end());
+    std::cout << (hit - text.begin()) << ' '
+              << exp_par::count_occurrences(p, text.begin(), text.end(), word.begin(), word.end())
+              << '\n';
+
+    std::cout << exp_par::is_sorted(p, v.begin(), v.end()) << ' '
+              << (exp_par::adjacent_find(p, v.begin(), v.end()) == v.end()) << '\n';
+
+    // Separate arrays traversed together.
+    std::vector<float> xs(1000, 1.0f), ys(1000, 2.0f);
+    exp_par::zip_iterator<std::vector<float>::iterator, std::vector<float>::iterator>
+        zb(xs.begin(), ys.begin()), ze(xs.end(), ys.end());
+    exp_par::for_each(exp_par::par_vec, zb, ze, [](auto t) { std::get<0>(t) += std::get<1>(t); });
+    std::cout << exp_par::count_if(exp_par::par_vec, zb, ze,
+                                   [](auto t) { return std::get<0>(t) == 3.0f; }) << '\n';
+
+    // Segmented ranges are chunked over their segments.
+    std::deque<int> dq(v.begin(), v.end());
+    std::vector<std::vector<int>> rows(100, std::vector<int>(10, 1));
+    auto cells = exp_par::flatten(rows);
+    std::cout << exp_par::count_if(p, dq.begin(), dq.end(), [](int i) { return i % 2 == 0; }) << ' '
+              << exp_par::count(p, cells.begin(), cells.end(), 1) << '\n';
+
+    // Independent stages overlap; only the edges order them.
+    exp_par::task_graph g;
+    long evens = 0, odds = 0;
+    auto refill = g.emplace([&] { exp_par::for_each(exp_par::par, t.begin(), t.end(), [](int& i) { i = 2 * i; }); });
+    auto count_evens_job = g.emplace([&] { evens = exp_par::count_if(exp_par::par, t.begin(), t.end(), [](int i) { return i % 2 == 0; }); });
+    g.emplace([&] { odds = exp_par::count_if(exp_par::par, v.begin(), v.end(), [](int i) { return i % 2 != 0; }); });
+    refill.precede(count_evens_job);
+    g.run();
+    std::cout << evens << ' ' << odds << '\n';
+
+    // Packed bits are counted and searched a word at a time.
+    std::vector<bool> occupied(100000, false);
+    for(std::size_t i = 0; i < occupied.size(); i += 4) { occupied[i] = true; }
+    std::cout << exp_par::count(exp_par::par, occupied.begin(), occupied.end(), true) << ' '
+              << exp_par::all_of(exp_par::par, occupied.begin(), occupied.end(), exp_par::bit_is_set{}) << ' '
+              << exp_par::any_of(exp_par::par, occupied.begin(), occupied.end(), std::logical_not<>{}) << '\n';
+
+    // Objects built in raw memory, and torn down again.
+    std::vector<std::string> names(1000, "name");
+    auto* raw = static_cast<std::string*>(::operator new(names.size() * sizeof(std::string)));
+    auto raw_end = exp_par::uninitialized_move(exp_par::par, names.begin(), names.end(), raw);
+    std::cout << (raw_end - raw) << ' ' << raw[999] << ' ' << names[999].empty() << '\n';
+    exp_par::destroy(exp_par::par, raw, raw_end);
+    ::operator delete(raw);
+
+    // Index loops with private accumulators and a running output pointer.
+    long index_sum = 0;
+    std::vector<int> squares(1000);
+    int* square = squares.data();
+    exp_par::for_loop(exp_par::par, 0, 1000, exp_par::reduction_plus(index_sum), exp_par::induction(square),
+                      [](int i, long& sum, int* out) { sum += i; *out = i * i; });
+    std::cout << index_sum << ' ' << squares[999] << ' ' << (square - squares.data()) << '\n';
+
+    // Under par_deterministic the private sums are combined like reduce's.
+    std::vector<double> noise(100000);
+    exp_par::generate_random(exp_par::par, noise.begin(), noise.end(), unit, 7);
+    double noise_sum = 0.0;
+    exp_par::for_loop(exp_par::par_deterministic, std::size_t(0), noise.size(),
+                      exp_par::reduction_plus(noise_sum),
+                      [&noise](std::size_t i, double& sum) { sum += noise[i]; });
+    std::cout << (noise_sum == exp_par::reduce(exp_par::par_deterministic,
+                                               noise.begin(), noise.end(), 0.0)) << '\n';
+
+    // A 2D stencil walked tile by tile along a Hilbert curve.
+    const std::size_t height = 300, width = 200;
+    std::vector<float> pixels(height * width, 1.0f), blurred(height * width, 0.0f);
+    exp_par::for_each_tile(exp_par::par_vec, exp_par::extents<2>{ height, width },
+                           exp_par::cache_tile<2>(sizeof(float)),
+                           [&](std::size_t y, std::size_t x) {
+                               const auto up = y > 0 ? y - 1 : y, down = y + 1 < height ? y + 1 : y;
+                               blurred[y * width + x] = (pixels[up * width + x] + pixels[y * width + x]
+                                                         + pixels[down * width + x]) / 3.0f;
+                           },
+                           exp_par::tile_order::hilbert);
+    std::cout << exp_par::count(exp_par::par, blurred.begin(), blurred.end(), 1.0f) << '\n';
+
+    // Worker processes over a shared memory segment.
+    exp_par::shared_array<int> shared(10000);
+    std::copy(v.begin(), v.begin() + 10000, shared.begin());
+    exp_par::for_each(exp_par::shared_memory_execution_policy(2), shared.begin(), shared.end(),
+                      [](int& i) { i = i % 2; });
+    std::cout << exp_par::reduce(exp_par::par_shm, shared.begin(), shared.end(), 0) << ' '
+              << exp_par::count(exp_par::par_shm, v.begin(), v.end(), 7) << '\n';
+
+    // Sorted shards merged and intersected with merge path splits.
+    std::vector<int> evens_ids, thirds_ids;
+    for(int i = 0; i < 30000; i += 2) { evens_ids.push_back(i); }
+    for(int i = 0; i < 30000; i += 3) { thirds_ids.push_back(i); }
+    std::vector<int> merged(evens_ids.size() + thirds_ids.size()), common(thirds_ids.size());
+    exp_par::merge(exp_par::par, evens_ids.begin(), evens_ids.end(),
+                   thirds_ids.begin(), thirds_ids.end(), merged.begin());
+    auto common_end = exp_par::set_intersection(exp_par::par_vec, evens_ids.begin(), evens_ids.end(),
+                                                thirds_ids.begin(), thirds_ids.end(), common.begin());
+    std::cout << exp_par::is_sorted(exp_par::par, merged.begin(), merged.end()) << ' '
+              << (common_end - common.begin()) << ' '
+              << exp_par::includes(exp_par::par, evens_ids.begin(), evens_ids.end(),
+                                   common.begin(), common_end) << '\n';
+
+    // inplace_merge with a comparator taking its arguments by value.
+    std::vector<std::string> labels, expected_labels;
+    for(int i = 0; i < 2000; ++i) { labels.push_back(std::to_string(i % 1000 * 7 % 1000) + " label"); }
+    std::sort(labels.begin(), labels.begin() + 700);
+    std::sort(labels.begin() + 700, labels.end());
+    expected_labels = labels;
+    auto by_value = [](std::string a, std::string b) { return a < b; };
+    std::inplace_merge(expected_labels.begin(), expected_labels.begin() + 700, expected_labels.end(), by_value);
+    exp_par::inplace_merge(exp_par::par, labels.begin(), labels.begin() + 700, labels.end(), by_value);
+    std::cout << (labels == expected_labels) << '\n';
+
+    // Per-shard totals of the merged ids, and the distinct shards.
+    std::vector<int> shard, shards(merged.size()), totals(merged.size());
+    for(int i : merged) { shard.push_back(i / 1000); }
+    auto ends = exp_par::reduce_by_key(exp_par::par, shard.begin(), shard.end(), merged.begin(),
+                                       shards.begin(), totals.begin());
+    std::vector<int> block_totals(merged.size());
+    exp_par::reduce_by_key(exp_par::par_deterministic, shard.begin(), shard.end(), merged.begin(),
+                           shards.begin(), block_totals.begin());
+    const bool same_totals = std::equal(totals.begin(), totals.begin() + 30, block_totals.begin());
+    auto distinct_end = exp_par::unique(exp_par::par, shard.begin(), shard.end());
+    std::cout << (ends.first - shards.begin()) << ' ' << totals[29] << ' '
+              << (distinct_end - shard.begin()) << ' ' << same_totals << '\n';
+
+    // The chunk bookkeeping is kept on the stack, for deques too.
+    const auto allocations_before = allocations.load();
+    exp_par::for_each(exp_par::par, t.begin(), t.end(), [](int& i) { i = i / 2; });
+    auto sevens = exp_par::count(exp_par::par, v.begin(), v.end(), 7);
+    auto deque_sevens = exp_par::count(exp_par::par, dq.begin(), dq.end(), 7);
+    auto same = exp_par::equal(exp_par::par, v.begin(), v.end(), t.begin(), t.end());
+    auto any_big = exp_par::any_of(exp_par::par, v.begin(), v.end(), [](int i) { return i > 99998; });
+    const auto chunk_allocations = allocations.load() - allocations_before;
+    std::cout << chunk_allocations << ' '
+              << sevens << ' ' << same << ' ' << any_big << ' ' << (deque_sevens == sevens) << '\n';
+    if(chunk_allocations != 0) {
+        std::cerr << "parallel calls allocated " << chunk_allocations << " times\n";
+        return EXIT_FAILURE;
+    }
+
+    // The controller tunes the thread count per size class when enabled.
+    auto& controller = exp_par::adaptive_concurrency::instance();
+    controller.enable();
+    for(int i = 0; i < 10; ++i) { exp_par::count(exp_par::par, v.begin(), v.end(), 7); }
+    controller.enable(false);
+    auto decisions = controller.stats();
+    std::cout << decisions.size() << ' ' << decisions[0].calls << '\n';
+
+#if defined(__cpp_impl_coroutine)
+    // Awaited without blocking; sync_wait only drives the coroutine here.
+    std::cout << exp_par::coro::sync_wait(count_evens(v)) << '\n';
+#endif
 }
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+// Iterators over elements laid out next to each other in memory, which lets
+// the vectorized code paths work on raw pointers. Pointers and the standard
+// library's vector and string iterators are recognized here; other iterator
+// types opt in by specializing the trait (see mapped_file.hpp).
+template <typename Iterator>
+struct is_contiguous_iterator
+    : std::integral_constant<bool, false>
+{ };
+
+template <typename T>
+struct is_contiguous_iterator<T*>
+    : std::integral_constant<bool, true>
+{ };
+
+#if defined(__GLIBCXX__)
+template <typename T, typename Container>
+struct is_contiguous_iterator<__gnu_cxx::__normal_iterator<T*, Container>>
+    : std::integral_constant<bool, true>
+{ };
+#endif
+
+template <typename Iterator>
+constexpr bool is_contiguous_iterator_v = is_contiguous_iterator<Iterator>::value;
+
+// Address of the element it refers to; it must be dereferenceable.
+template <typename Iterator>
+auto to_pointer(Iterator it)
+{
+    return std::addressof(*it);
+}
+
+} // end namespace internal
+} // end namespace parallel
+} // end namespace experimental
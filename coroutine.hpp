@@ -0,0 +1,604 @@
+#pragma once
+
+// Awaitable versions of the algorithms, for code built on C++20 coroutines.
+// Everything here is only available when the compiler supports coroutines
+// (e.g. -std=c++20); the rest of the library stays C++14.
+//
+//     using namespace experimental::parallel;
+//
+//     coro::task<long> count_errors(const std::vector<record>& log)
+//     {
+//         co_return co_await coro::count_if(par, log.begin(), log.end(), is_error);
+//     }
+//
+//     auto n = coro::sync_wait(count_errors(log));
+//
+// Awaiting one of the algorithms submits all of its chunks to the shared
+// worker pool and suspends the awaiting coroutine; the calling thread is not
+// blocked and doesn't take part in the work. Whichever worker finishes the
+// last chunk resumes the coroutine, so execution continues on that worker.
+// The sequential policy runs the algorithm inline, without suspending.
+//
+// The algorithms live in the coro namespace since they return awaitables
+// rather than results, and would otherwise clash with the blocking overloads.
+// task and sync_wait are a minimal coroutine type and driver, so that nothing
+// beyond the standard library is needed to use or test them.
+
+#if defined(__cpp_impl_coroutine)
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "execution_policy.hpp"
+#include "thread_pool.hpp"
+#include "uninitialized.hpp"
+
+namespace experimental
+{
+namespace parallel
+{
+namespace coro
+{
+
+//================================================================================
+//===================================task=========================================
+//================================================================================
+
+template <typename T = void>
+class task;
+
+namespace detail
+{
+
+// Hands control straight back to whoever awaited the finished task.
+struct final_awaiter
+{
+    bool await_ready() noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+    {
+        auto continuation = h.promise().continuation;
+        return continuation ? continuation : std::noop_coroutine();
+    }
+
+    void await_resume() noexcept { }
+};
+
+class promise_base
+{
+public:
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    final_awaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+};
+
+template <typename T>
+class promise
+    : public promise_base
+{
+public:
+
+    task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+    T result()
+    {
+        if(error) { std::rethrow_exception(error); }
+        return std::move(*value);
+    }
+
+private:
+
+    std::optional<T> value;
+};
+
+template <>
+class promise<void>
+    : public promise_base
+{
+public:
+
+    task<void> get_return_object() noexcept;
+
+    void return_void() noexcept { }
+
+    void result()
+    {
+        if(error) { std::rethrow_exception(error); }
+    }
+};
+
+} // end namespace detail
+
+// A lazily started coroutine producing a T. It starts running when it is
+// awaited, and resumes its awaiter when it finishes.
+template <typename T>
+class task
+{
+public:
+
+    using promise_type = detail::promise<T>;
+
+    task(task&& other) noexcept
+        : handle(std::exchange(other.handle, nullptr))
+    { }
+
+    task& operator=(task&& other) noexcept
+    {
+        if(&other != this) {
+            if(handle) { handle.destroy(); }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    ~task()
+    {
+        if(handle) { handle.destroy(); }
+    }
+
+    auto operator co_await() && noexcept
+    {
+        struct awaiter
+        {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() { return handle.promise().result(); }
+        };
+        return awaiter{handle};
+    }
+
+private:
+
+    friend class detail::promise<T>;
+
+    explicit task(std::coroutine_handle<promise_type> handle)
+        : handle(handle)
+    { }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+namespace detail
+{
+
+template <typename T>
+task<T> promise<T>::get_return_object() noexcept
+{
+    return task<T>(std::coroutine_handle<promise<T>>::from_promise(*this));
+}
+
+inline task<void> promise<void>::get_return_object() noexcept
+{
+    return task<void>(std::coroutine_handle<promise<void>>::from_promise(*this));
+}
+
+//================================================================================
+
+class sync_latch
+{
+public:
+
+    void set()
+    {
+        // Notify under the lock: the waiter owns the latch and may destroy it
+        // as soon as it can observe done.
+        std::lock_guard<std::mutex> lock(m);
+        done = true;
+        cv.notify_all();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this] { return done; });
+    }
+
+private:
+
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+// Top-level coroutine used by sync_wait: it is started explicitly and sets
+// the latch once it has run to completion.
+class sync_wait_task
+{
+public:
+
+    class promise_type
+    {
+    public:
+
+        sync_wait_task get_return_object() noexcept
+        { return sync_wait_task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept
+        {
+            struct final_awaiter
+            {
+                bool await_ready() noexcept { return false; }
+
+                void await_suspend(std::coroutine_handle<promise_type> h) noexcept
+                { h.promise().latch->set(); }
+
+                void await_resume() noexcept { }
+            };
+            return final_awaiter{};
+        }
+
+        void return_void() noexcept { }
+        void unhandled_exception() noexcept { std::terminate(); }
+
+        sync_latch* latch = nullptr;
+    };
+
+    sync_wait_task(sync_wait_task&& other) noexcept
+        : handle(std::exchange(other.handle, nullptr))
+    { }
+
+    ~sync_wait_task()
+    {
+        if(handle) { handle.destroy(); }
+    }
+
+    void run_and_wait()
+    {
+        sync_latch latch;
+        handle.promise().latch = &latch;
+        handle.resume();
+        latch.wait();
+    }
+
+private:
+
+    explicit sync_wait_task(std::coroutine_handle<promise_type> handle)
+        : handle(handle)
+    { }
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <typename T>
+sync_wait_task sync_wait_run(task<T> t, std::optional<T>& out, std::exception_ptr& error)
+{
+    try { out.emplace(co_await std::move(t)); }
+    catch(...) { error = std::current_exception(); }
+}
+
+inline sync_wait_task sync_wait_run(task<void> t, std::exception_ptr& error)
+{
+    try { co_await std::move(t); }
+    catch(...) { error = std::current_exception(); }
+}
+
+} // end namespace detail
+
+// Runs t to completion, blocking the calling thread, and returns its result.
+template <typename T>
+T sync_wait(task<T> t)
+{
+    std::optional<T> result;
+    std::exception_ptr error;
+    detail::sync_wait_run(std::move(t), result, error).run_and_wait();
+    if(error) { std::rethrow_exception(error); }
+    return std::move(*result);
+}
+
+inline void sync_wait(task<void> t)
+{
+    std::exception_ptr error;
+    detail::sync_wait_run(std::move(t), error).run_and_wait();
+    if(error) { std::rethrow_exception(error); }
+}
+
+//================================================================================
+//================================Awaitables======================================
+//================================================================================
+
+namespace detail
+{
+
+// Maps every chunk of [0, size) to a partial result with f(first, last) on
+// the pool and folds them in chunk order with combine, like reduce_chunks,
+// but suspends the awaiting coroutine instead of waiting. With run_inline
+// (or nothing to do) it computes the result in await_ready instead.
+template <typename T, typename Func, typename Combine>
+class reduce_awaitable
+{
+public:
+
+    reduce_awaitable(std::size_t size, T init, Func f, Combine combine, bool run_inline)
+        : size(size), init(std::move(init)), f(std::move(f)), combine(std::move(combine)),
+          run_inline(run_inline)
+    { }
+
+    // Only valid before the awaitable is awaited.
+    reduce_awaitable(reduce_awaitable&& other)
+        : size(other.size), init(std::move(other.init)), f(std::move(other.f)),
+          combine(std::move(other.combine)), run_inline(other.run_inline)
+    { }
+
+    bool await_ready()
+    {
+        if(!run_inline && size > 0) { return false; }
+        result.emplace(combine(init, f(0, size)));
+        return true;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting)
+    {
+        continuation = awaiting;
+
+        const auto n = internal::chunk_count(size);
+        pending.store(n, std::memory_order_relaxed);
+        partial.assign(n, slot{init});
+        tasks.reserve(n);
+        for(std::size_t i = 0; i < n; ++i) {
+            tasks.emplace_back(this, i, internal::chunk_begin(i, n, size),
+                               internal::chunk_begin(i + 1, n, size));
+        }
+
+        // The coroutine may be resumed, and this object destroyed, before
+        // submit returns.
+        internal::thread_pool::instance().submit(tasks.begin(), tasks.end());
+    }
+
+    T await_resume()
+    {
+        if(error) { std::rethrow_exception(error); }
+        if(result) { return std::move(*result); }
+
+        T r = init;
+        for(auto&& p : partial) { r = combine(r, p.value); }
+        return r;
+    }
+
+private:
+
+    struct slot { T value; };
+
+    class chunk
+        : public internal::pool_task
+    {
+    public:
+
+        chunk(reduce_awaitable* self, std::size_t index, std::size_t first, std::size_t last)
+            : self(self), index(index), first(first), last(last)
+        { }
+
+        void execute() noexcept override { self->run(index, first, last); }
+
+    private:
+
+        reduce_awaitable* self;
+        std::size_t index;
+        std::size_t first;
+        std::size_t last;
+    };
+
+    void run(std::size_t index, std::size_t first, std::size_t last) noexcept
+    {
+        try { partial[index].value = f(first, last); }
+        catch(...) {
+            if(!failed.exchange(true)) { error = std::current_exception(); }
+        }
+        if(pending.fetch_sub(1, std::memory_order_acq_rel) == 1) { continuation.resume(); }
+    }
+
+    std::size_t size;
+    T init;
+    Func f;
+    Combine combine;
+    bool run_inline;
+
+    std::optional<T> result;
+    std::vector<slot> partial;
+    std::vector<chunk> tasks;
+    std::atomic<std::size_t> pending{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::coroutine_handle<> continuation;
+};
+
+template <typename T, typename Func, typename Combine>
+reduce_awaitable<T, Func, Combine> make_reduce_awaitable(
+    std::size_t size, T init, Func f, Combine combine, bool run_inline
+)
+{
+    return { size, std::move(init), std::move(f), std::move(combine), run_inline };
+}
+
+// Runs f(begin_chunk, end_chunk) for every chunk and folds the results.
+// Iterators without random access can't be split, so they go to the pool as
+// a single chunk, which still keeps the calling thread free.
+template <typename ExecutionPolicy, typename InputIt, typename T, typename Func,
+          typename Combine>
+auto chunked(ExecutionPolicy&&, InputIt begin, InputIt end, T init, Func f, Combine combine)
+{
+    using policy_type = std::decay_t<ExecutionPolicy>;
+    const bool run_inline = std::is_same<policy_type, sequential_execution_policy>::value;
+
+    if constexpr(internal::is_random_iterator_v<InputIt>) {
+        const auto size = static_cast<std::size_t>(std::distance(begin, end));
+        return make_reduce_awaitable(size, std::move(init),
+            [begin, f](std::size_t first, std::size_t last) {
+                auto begin_chunk = begin + first;
+                auto end_chunk = begin + last;
+                using internal::chunk_hint;
+                chunk_hint(begin_chunk, end_chunk);
+                return f(begin_chunk, end_chunk);
+            },
+            std::move(combine), run_inline);
+    }
+    else {
+        return make_reduce_awaitable(std::size_t(begin == end ? 0 : 1), std::move(init),
+            [begin, end, f](std::size_t, std::size_t) { return f(begin, end); },
+            std::move(combine), run_inline);
+    }
+}
+
+// An awaitable that gives nothing back, for algorithms run only for their
+// effects.
+template <typename Awaitable>
+class discard_result
+{
+public:
+
+    explicit discard_result(Awaitable awaitable)
+        : awaitable(std::move(awaitable))
+    { }
+
+    bool await_ready() { return awaitable.await_ready(); }
+    void await_suspend(std::coroutine_handle<> awaiting) { awaitable.await_suspend(awaiting); }
+    void await_resume() { (void)awaitable.await_resume(); }
+
+private:
+
+    Awaitable awaitable;
+};
+
+template <typename ExecutionPolicy>
+using enable_if_policy =
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type;
+
+} // end namespace detail
+
+//================================================================================
+
+// The policy can be any of the policy types; the type-erased
+// execution_policy is not supported, since the type of the awaitable depends
+// on the policy.
+
+template <typename ExecutionPolicy, typename InputIt, typename Func,
+          typename = detail::enable_if_policy<ExecutionPolicy>>
+auto for_each(ExecutionPolicy&& policy, InputIt begin, InputIt end, Func func)
+{
+    return detail::discard_result(
+        detail::chunked(std::forward<ExecutionPolicy>(policy), begin, end, 0,
+            [func](auto first, auto last) {
+                for(; first != last; ++first) { func(*first); }
+                return 0;
+            },
+            [](int, int) { return 0; }));
+}
+
+template <typename ExecutionPolicy, typename InputIt, typename UnaryPredicate,
+          typename = detail::enable_if_policy<ExecutionPolicy>>
+auto count_if(ExecutionPolicy&& policy, InputIt begin, InputIt end, UnaryPredicate p)
+{
+    using difference_type = typename std::iterator_traits<InputIt>::difference_type;
+
+    return detail::chunked(std::forward<ExecutionPolicy>(policy), begin, end,
+        difference_type(0),
+        [p](auto first, auto last) {
+            difference_type seen = 0;
+            for(; first != last; ++first) {
+                if(p(*first)) { ++seen; }
+            }
+            return seen;
+        },
+        [](difference_type a, difference_type b) { return a + b; });
+}
+
+template <typename ExecutionPolicy, typename InputIt, typename T,
+          typename = detail::enable_if_policy<ExecutionPolicy>>
+auto count(ExecutionPolicy&& policy, InputIt begin, InputIt end, const T& value)
+{
+    return count_if(std::forward<ExecutionPolicy>(policy), begin, end,
+                    [value](const auto& input) { return input == value; });
+}
+
+// any_of, all_of and none_of let every chunk stop as soon as any chunk has
+// found an element that decides the result.
+template <typename ExecutionPolicy, typename InputIt, typename Predicate,
+          typename = detail::enable_if_policy<ExecutionPolicy>>
+auto any_of(ExecutionPolicy&& policy, InputIt begin, InputIt end, Predicate p)
+{
+    auto found = std::make_shared<std::atomic<bool>>(false);
+    return detail::chunked(std::forward<ExecutionPolicy>(policy), begin, end, false,
+        [p, found](auto first, auto last) {
+            for(; first != last && !found->load(std::memory_order_relaxed); ++first) {
+                if(p(*first)) {
+                    found->store(true, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        },
+        [](bool a, bool b) { return a || b; });
+}
+
+template <typename ExecutionPolicy, typename InputIt, typename Predicate,
+          typename = detail::enable_if_policy<ExecutionPolicy>>
+auto all_of(ExecutionPolicy&& policy, InputIt begin, InputIt end, Predicate p)
+{
+    auto failed = std::make_shared<std::atomic<bool>>(false);
+    return detail::chunked(std::forward<ExecutionPolicy>(policy), begin, end, true,
+        [p, failed](auto first, auto last) {
+            for(; first != last && !failed->load(std::memory_order_relaxed); ++first) {
+                if(!p(*first)) {
+                    failed->store(true, std::memory_order_relaxed);
+                    return false;
+                }
+            }
+            return true;
+        },
+        [](bool a, bool b) { return a && b; });
+}
+
+template <typename ExecutionPolicy, typename InputIt, typename Predicate,
+          typename = detail::enable_if_policy<ExecutionPolicy>>
+auto none_of(ExecutionPolicy&& policy, InputIt begin, InputIt end, Predicate p)
+{
+    auto found = std::make_shared<std::atomic<bool>>(false);
+    return detail::chunked(std::forward<ExecutionPolicy>(policy), begin, end, true,
+        [p, found](auto first, auto last) {
+            for(; first != last && !found->load(std::memory_order_relaxed); ++first) {
+                if(p(*first)) {
+                    found->store(true, std::memory_order_relaxed);
+                    return false;
+                }
+            }
+            return true;
+        },
+        [](bool a, bool b) { return a && b; });
+}
+
+} // end namespace coro
+} // end namespace parallel
+} // end namespace experimental
+
+#endif // defined(__cpp_impl_coroutine)
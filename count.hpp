@@ -1,14 +1,23 @@
 #pragma once
 
 #include <algorithm>
-#include <future>
+#include <atomic>
+#include <functional>
 #include <iterator>
 #include <thread>
 #include <type_traits>
 #include <vector>
 
+#include "adaptive.hpp"
+#include "bits.hpp"
+#include "cancellation.hpp"
 #include "execution_policy.hpp"
 #include "dispatch.hpp"
+#include "hardware_conc.hpp"
+#include "segmented.hpp"
+#include "streaming.hpp"
+#include "thread_pool.hpp"
+#include "zip_iterator.hpp"
 
 namespace experimental
 {
@@ -63,49 +72,68 @@ template <typename InputIt, typename Predicate>
 typename std::iterator_traits<InputIt>::difference_type
 count_impl_base(
     parallel_execution_policy, InputIt begin, InputIt end, Predicate p,
-    enable_if_random<InputIt>* = 0 
+    enable_if_random<InputIt>* = 0, enable_if_not_segmented<InputIt>* = 0
 )
 {
     using return_type = typename std::iterator_traits<InputIt>::difference_type;
-    using future_type = std::future<return_type>;
-
-    const static unsigned hc = 2 * get_hardware_concurrency_or_default();
-    const auto size = std::distance(begin, end);
-    const auto chunk_size = static_cast<std::size_t>(size) / hc;
-    std::vector<future_type> tasks;
-
-    tasks.reserve(hc);
-    
-    for(auto i = 0U; i < hc; ++i) {
-        const unsigned i_chunk = i * chunk_size;
-        const unsigned next_i_chunk = i_chunk + chunk_size; 
-        tasks.emplace_back(
-            std::async(
-                std::launch::async,
-                [begin, i_chunk, next_i_chunk, p] { 
-                return_type seen{0};
-                auto begin_chunk = begin + i_chunk;
-                auto end_chunk = begin + next_i_chunk;
-                for(; begin_chunk != end_chunk; ++begin_chunk) {
-                    if(p(*begin_chunk)) ++seen;
-                }
-                return seen;
-            })
-        );
-    }
 
-    return_type seen{0};
-    for(auto&& task : tasks) { seen += task.get(); }
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    adaptive_call call(adaptive_kernel::count, size);
+
+    const auto seen = reduce_chunks(size, call.chunks(), return_type{0},
+        [begin, p](std::size_t first, std::size_t last) {
+            return_type seen{0};
+            auto begin_chunk = begin + first;
+            auto end_chunk = begin + last;
+            chunk_hint(begin_chunk, end_chunk);
+            for(; begin_chunk != end_chunk; ++begin_chunk) {
+                if(p(*begin_chunk)) ++seen;
+            }
+            return seen;
+        },
+        [](return_type a, return_type b) { return a + b; });
+
+    call.done();
     return seen;
 }
 
+// Segmented iterators (std::deque, flatten): chunks run over the local
+// iterators of each segment, see segmented.hpp.
+template <typename InputIt, typename Predicate>
+typename std::iterator_traits<InputIt>::difference_type
+count_impl_base(
+    parallel_execution_policy, InputIt begin, InputIt end, Predicate p,
+    enable_if_segmented<InputIt>* = 0
+)
+{
+    using return_type = typename std::iterator_traits<InputIt>::difference_type;
+
+    struct slot { return_type value; };
+
+    const segment_chunks<InputIt> pieces(begin, end);
+    const auto n = chunk_count(pieces.size());
+    inline_buffer<slot, inline_slots<slot>> partial(n);
+    for(std::size_t i = 0; i < n; ++i) { partial.emplace_back(slot{0}); }
+    pieces.for_each_chunk([&partial, &p](std::size_t i, auto first, auto last) {
+        return_type seen{0};
+        for(; first != last; ++first) {
+            if(p(*first)) ++seen;
+        }
+        partial[i].value += seen;
+    });
+
+    return_type result{0};
+    for(auto&& s : partial) { result += s.value; }
+    return result;
+}
+
 //================================================================================
 
 template <typename InputIt, typename T>
 typename std::iterator_traits<InputIt>::difference_type
 count_impl(
     parallel_execution_policy pep, InputIt begin, InputIt end, const T& value, 
-    enable_if_random<InputIt>* = 0
+    enable_if_random<InputIt>* = 0, enable_if_not_bit_iterator<InputIt>* = 0
 )
 {
     return count_impl_base(pep, begin, end, 
@@ -116,34 +144,110 @@ template <typename InputIt, typename Predicate>
 typename std::iterator_traits<InputIt>::difference_type
 count_if_impl(
     parallel_execution_policy pep, InputIt begin, InputIt end, Predicate p,
-    enable_if_random<InputIt>* = 0
+    enable_if_random<InputIt>* = 0, enable_if_not_bit_test<InputIt, Predicate>* = 0
 )
 {
     return count_impl_base(pep, begin, end, p);
 }
 
-template <typename InputIt, typename T> 
+// Bit-packed ranges are counted a word at a time, see bits.hpp.
+template <typename InputIt, typename T>
 typename std::iterator_traits<InputIt>::difference_type
 count_impl(
     parallel_execution_policy, InputIt begin, InputIt end, const T& value,
+    enable_if_bit_iterator<InputIt>* = 0
+)
+{
+    using return_type = typename std::iterator_traits<InputIt>::difference_type;
+
+    const auto ones = static_cast<return_type>(count_set_bits(begin, end));
+    const auto zeros = (end - begin) - ones;
+    return (true == value ? ones : 0) + (false == value ? zeros : 0);
+}
+
+template <typename InputIt, typename Predicate>
+typename std::iterator_traits<InputIt>::difference_type
+count_if_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, Predicate,
+    enable_if_bit_test<InputIt, Predicate>* = 0
+)
+{
+    using return_type = typename std::iterator_traits<InputIt>::difference_type;
+
+    const auto ones = static_cast<return_type>(count_set_bits(begin, end));
+    return bit_predicate<Predicate>::satisfied_by ? ones : (end - begin) - ones;
+}
+
+// Iterators that can't be split up front are streamed to the workers in
+// blocks, see streaming.hpp.
+template <typename InputIt, typename Predicate>
+typename std::iterator_traits<InputIt>::difference_type
+count_impl_base(
+    parallel_execution_policy, InputIt begin, InputIt end, Predicate p,
+    enable_if_not_random<InputIt>* = 0, enable_if_not_segmented<InputIt>* = 0
+)
+{
+    using return_type = typename std::iterator_traits<InputIt>::difference_type;
+
+    // Counted per block, so the shared total is only touched once a block.
+    std::atomic<return_type> seen{0};
+    stream_for_each_block(begin, end, [&seen, &p](const auto& block) {
+        return_type matches = 0;
+        auto count_match = [&matches, &p](auto&& x) {
+            if(p(x)) { ++matches; }
+            return true;
+        };
+        block.for_each(count_match);
+        seen.fetch_add(matches, std::memory_order_relaxed);
+        return true;
+    });
+    return seen;
+}
+
+template <typename InputIt, typename T> 
+typename std::iterator_traits<InputIt>::difference_type
+count_impl(
+    parallel_execution_policy pep, InputIt begin, InputIt end, const T& value,
     enable_if_not_random<InputIt>* = 0    
 )
 {
-    return std::count(begin, end, value);
+    return count_impl_base(pep, begin, end, 
+        [&value](const T& input) { return input == value; });
 }
 
 template <typename InputIt, typename UnaryPredicate> 
 typename std::iterator_traits<InputIt>::difference_type
 count_if_impl(
-    parallel_execution_policy, InputIt begin, InputIt end, UnaryPredicate p,
+    parallel_execution_policy pep, InputIt begin, InputIt end, UnaryPredicate p,
     enable_if_not_random<InputIt>* = 0
 )
 {
-    return std::count_if(begin, end, p);
+    return count_impl_base(pep, begin, end, p);
 }
 
 //================================================================================
 
+// Zipped contiguous arrays: every chunk indexes the raw arrays directly and
+// sums the predicate results without branching, see zip_iterator.hpp.
+template <typename... Iterators, typename Predicate>
+std::ptrdiff_t count_impl_base(
+    parallel_vector_execution_policy,
+    zip_iterator<Iterators...> begin, zip_iterator<Iterators...> end, Predicate p
+)
+{
+    const auto size = static_cast<std::size_t>(end - begin);
+    if(size == 0) { return 0; }
+
+    const zip_pointers<Iterators...> arrays(begin);
+    return reduce_chunks(size, std::ptrdiff_t(0),
+        [&arrays, &p](std::size_t first, std::size_t last) {
+            std::ptrdiff_t seen = 0;
+            for(auto j = first; j != last; ++j) { seen += p(arrays[j]) ? 1 : 0; }
+            return seen;
+        },
+        std::plus<>{});
+}
+
 template <typename InputIt, typename T>
 typename std::iterator_traits<InputIt>::difference_type
 count_impl(
@@ -153,6 +257,17 @@ count_impl(
     return count_impl(par, begin, end, value);
 }
 
+template <typename... Iterators, typename T>
+std::ptrdiff_t count_impl(
+    parallel_vector_execution_policy pvep,
+    zip_iterator<Iterators...> begin, zip_iterator<Iterators...> end, const T& value,
+    typename std::enable_if<is_contiguous_zip_v<zip_iterator<Iterators...>>>::type* = 0
+)
+{
+    return count_impl_base(pvep, begin, end,
+        [&value](const auto& input) { return input == value; });
+}
+
 template <typename InputIt, typename UnaryPredicate>
 typename std::iterator_traits<InputIt>::difference_type
 count_if_impl(
@@ -162,6 +277,80 @@ count_if_impl(
     return count_if_impl(par, begin, end, p);
 }
 
+template <typename... Iterators, typename UnaryPredicate>
+std::ptrdiff_t count_if_impl(
+    parallel_vector_execution_policy pvep,
+    zip_iterator<Iterators...> begin, zip_iterator<Iterators...> end, UnaryPredicate p,
+    typename std::enable_if<is_contiguous_zip_v<zip_iterator<Iterators...>>>::type* = 0
+)
+{
+    return count_impl_base(pvep, begin, end, p);
+}
+
+//================================================================================
+//=========================Cancellable Overloads==================================
+//================================================================================
+
+template <typename InputIt, typename Predicate>
+cancellable_result<typename std::iterator_traits<InputIt>::difference_type>
+count_impl_base(
+    sequential_execution_policy, InputIt begin, InputIt end, Predicate p,
+    const cancellation_token& token
+)
+{
+    using return_type = typename std::iterator_traits<InputIt>::difference_type;
+
+    return_type seen{0};
+    const bool completed = cancellable_for_each(begin, end, token,
+        [&seen, &p](auto&& v) { if(p(v)) ++seen; });
+    return { seen, completed ? completion_status::completed 
+                             : completion_status::cancelled };
+}
+
+template <typename InputIt, typename Predicate>
+cancellable_result<typename std::iterator_traits<InputIt>::difference_type>
+count_impl_base(
+    parallel_execution_policy, InputIt begin, InputIt end, Predicate p,
+    const cancellation_token& token, enable_if_random<InputIt>* = 0 
+)
+{
+    using return_type = typename std::iterator_traits<InputIt>::difference_type;
+    using result_type = cancellable_result<return_type>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+
+    return reduce_chunks(size, result_type{0, completion_status::completed},
+        [begin, p, &token](std::size_t first, std::size_t last) {
+            chunk_hint(begin + first, begin + last);
+            return count_impl_base(seq, begin + first, begin + last, p, token);
+        },
+        [](result_type a, result_type b) {
+            a.value += b.value;
+            if(b.cancelled()) { a.status = completion_status::cancelled; }
+            return a;
+        });
+}
+
+template <typename InputIt, typename Predicate>
+cancellable_result<typename std::iterator_traits<InputIt>::difference_type>
+count_impl_base(
+    parallel_execution_policy, InputIt begin, InputIt end, Predicate p,
+    const cancellation_token& token, enable_if_not_random<InputIt>* = 0 
+)
+{
+    return count_impl_base(seq, begin, end, p, token);
+}
+
+template <typename InputIt, typename Predicate>
+cancellable_result<typename std::iterator_traits<InputIt>::difference_type>
+count_impl_base(
+    parallel_vector_execution_policy, InputIt begin, InputIt end, Predicate p,
+    const cancellation_token& token
+)
+{
+    return count_impl_base(par, begin, end, p, token);
+}
+
 //================================================================================
 
 } // end namespace internal
@@ -175,7 +364,7 @@ count(
     typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
 )
 { 
-    internal::count_impl(policy, begin, end, value);
+    return internal::count_impl(policy, begin, end, value);
 }
 
 template <typename InputIt, typename T>
@@ -196,7 +385,7 @@ count_if(
     typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
 )
 { 
-    internal::count_if_impl(policy, begin, end, p);
+    return internal::count_if_impl(policy, begin, end, p);
 }
 
 template <typename InputIt, typename UnaryPredicate>
@@ -210,6 +399,56 @@ count_if(
     return internal::dispatch(policy, func);
 }
 
+// Cancellable overloads: workers poll the token once per block of elements
+// and stop early once it is cancelled or its deadline has passed. The result
+// then holds the count over the elements visited so far.
+template <typename ExecutionPolicy, typename InputIt, typename T>
+cancellable_result<typename std::iterator_traits<InputIt>::difference_type>
+count(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, const T& value,
+    const cancellation_token& token,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{ 
+    return internal::count_impl_base(policy, begin, end, 
+        [&value](const T& input) { return input == value; }, token);
+}
+
+template <typename InputIt, typename T>
+cancellable_result<typename std::iterator_traits<InputIt>::difference_type>
+count(
+    execution_policy policy, InputIt begin, InputIt end, const T& value,
+    const cancellation_token& token
+)
+{ 
+    auto pred = [&value](const T& input) { return input == value; };
+    auto func = [begin, end, pred, &token](auto policy)
+             { return internal::count_impl_base(policy, begin, end, pred, token); };
+    return internal::dispatch(policy, func);
+}
+
+template <typename ExecutionPolicy, typename InputIt, typename UnaryPredicate>
+cancellable_result<typename std::iterator_traits<InputIt>::difference_type>
+count_if(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, UnaryPredicate p,
+    const cancellation_token& token,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{ 
+    return internal::count_impl_base(policy, begin, end, p, token);
+}
+
+template <typename InputIt, typename UnaryPredicate>
+cancellable_result<typename std::iterator_traits<InputIt>::difference_type>
+count_if(
+    execution_policy policy, InputIt begin, InputIt end, UnaryPredicate p,
+    const cancellation_token& token
+)
+{ 
+    auto func = [begin, end, p, &token](auto policy)
+             { return internal::count_impl_base(policy, begin, end, p, token); };
+    return internal::dispatch(policy, func);
+}
+
 } // end namespace parallel
 } // end namespace experimental
-
@@ -22,6 +22,10 @@ auto dispatch(execution_policy p, Func f, Args&&... args)
         auto* pol = p.get<parallel_execution_policy>();
         return f(*pol, std::forward<Args>(args)...);
     }
+    else if(p.target_type() == typeid(par_deterministic)) {
+        auto* pol = p.get<parallel_deterministic_execution_policy>();
+        return f(*pol, std::forward<Args>(args)...);
+    }
     else if(p.target_type() == typeid(par_vec)) {
         auto* pol = p.get<parallel_vector_execution_policy>();
         return f(*pol, std::forward<Args>(args)...);
@@ -2,16 +2,17 @@
 
 #include <algorithm>
 #include <atomic>
-#include <future>
 #include <iterator>
 #include <thread>
 #include <type_traits>
 #include <typeinfo>
 #include <vector>
 
+#include "adaptive.hpp"
 #include "dispatch.hpp"
 #include "execution_policy.hpp"
 #include "hardware_conc.hpp"
+#include "thread_pool.hpp"
 
 namespace experimental
 {
@@ -38,9 +39,6 @@ constexpr bool is_simple = std::is_nothrow_copy_constructible<T>::value &&
 template <typename T>
 constexpr bool by_value = is_small<T> && is_simple<T>;
 
-template <typename T>
-constexpr bool is_arithmetic_v = std::is_arithmetic<T>::value;
-
 template <typename IterType>
 using pass_type = 
     typename std::conditional<
@@ -115,40 +113,32 @@ bool equal_impl(
     std::random_access_iterator_tag, Predicate pred 
 )
 {
-    const static unsigned hc = 2 * get_hardware_concurrency_or_default();
     const auto size = std::distance(begin1, end1);
 
     if(size != std::distance(begin2, end2)) { return false; }
 
-    const auto chunk_size = static_cast<std::size_t>(size) / hc;
-    std::vector<std::future<void>> tasks;
-    tasks.reserve(hc);
-
     std::atomic<bool> are_same{true};
-    
-    for(auto i = 0U; i < hc; ++i) {
-        const unsigned i_chunk = i * chunk_size;
-        const unsigned next_i_chunk = i_chunk + chunk_size; 
-        tasks.emplace_back(
-            std::async(
-                std::launch::async,
-                [begin1, begin2, i_chunk, next_i_chunk, pred, &are_same] { 
-                auto begin = begin1 + i_chunk;
-                auto end = begin1 + next_i_chunk;
-                auto begin2nd = begin2 + i_chunk;
-                while(begin != end && are_same.load(std::memory_order_relaxed)) 
-                {
-                    if(!pred(*begin, *begin2nd)) { 
-                        are_same.store(false, std::memory_order_relaxed); 
-                        return; 
-                    }
-                    ++begin; ++begin2nd;
-                }
-            })
-        );
-    }
-
-    for(auto&& task : tasks) { task.get(); }
+    adaptive_call call(adaptive_kernel::equal, static_cast<std::size_t>(size));
+
+    for_each_chunk(static_cast<std::size_t>(size), call.chunks(),
+        [begin1, begin2, pred, &are_same](std::size_t, std::size_t first, std::size_t last) { 
+        auto begin = begin1 + first;
+        auto end = begin1 + last;
+        auto begin2nd = begin2 + first;
+        chunk_hint(begin, end);
+        chunk_hint(begin2nd, begin2 + last);
+        while(begin != end && are_same.load(std::memory_order_relaxed)) 
+        {
+            if(!pred(*begin, *begin2nd)) { 
+                are_same.store(false, std::memory_order_relaxed); 
+                return; 
+            }
+            ++begin; ++begin2nd;
+        }
+    });
+
+    // A mismatch ends the call early, which says nothing about throughput.
+    if(are_same) { call.done(); }
     return are_same;
 }
 
@@ -14,11 +14,13 @@ namespace parallel
 
 class sequential_execution_policy;
 class parallel_execution_policy;
+class parallel_deterministic_execution_policy;
 class parallel_vector_execution_policy;
 class execution_policy;
 
 void swap(sequential_execution_policy& p1, sequential_execution_policy& p2);
 void swap(parallel_execution_policy& p1, parallel_execution_policy& p2);
+void swap(parallel_deterministic_execution_policy& p1, parallel_deterministic_execution_policy& p2);
 void swap(parallel_vector_execution_policy& p1, parallel_vector_execution_policy& p2);
 void swap(execution_policy& p1, execution_policy& p2);
 
@@ -39,6 +41,11 @@ struct is_execution_policy<parallel_execution_policy>
     : std::integral_constant<bool, true>
 { };
 
+template <>
+struct is_execution_policy<parallel_deterministic_execution_policy>
+    : std::integral_constant<bool, true>
+{ };
+
 template <>
 struct is_execution_policy<parallel_vector_execution_policy>
     : std::integral_constant<bool, true>
@@ -75,6 +82,22 @@ public:
 
 //================================================================================
 
+// Parallel execution whose results don't depend on the number of threads.
+// Algorithms that combine partial results in a way that can change the result
+// (floating point reductions) split the range into fixed-size blocks and
+// combine the blocks' results along a fixed tree, so they are bitwise
+// reproducible on any machine. Every other algorithm treats it as par.
+class parallel_deterministic_execution_policy
+    : public parallel_execution_policy
+{
+public:
+
+    parallel_deterministic_execution_policy() = default;
+    void swap(parallel_deterministic_execution_policy&) { }
+};
+
+//================================================================================
+
 class parallel_vector_execution_policy 
 { 
 public:
@@ -95,6 +118,11 @@ void swap(parallel_execution_policy& p1, parallel_execution_policy& p2)
     p1.swap(p2);
 }
 
+void swap(parallel_deterministic_execution_policy& p1, parallel_deterministic_execution_policy& p2)
+{
+    p1.swap(p2);
+}
+
 void swap(parallel_vector_execution_policy& p1, parallel_vector_execution_policy& p2)
 {
     p1.swap(p2);
@@ -104,6 +132,7 @@ void swap(parallel_vector_execution_policy& p1, parallel_vector_execution_policy
 
 constexpr sequential_execution_policy seq{};
 constexpr parallel_execution_policy par{};
+constexpr parallel_deterministic_execution_policy par_deterministic{};
 constexpr parallel_vector_execution_policy par_vec{};
 
 //================================================================================
@@ -167,6 +196,7 @@ public:
         switch(which) {
             case policy_type::sequential: return typeid(seq); 
             case policy_type::parallel: return typeid(par); 
+            case policy_type::deterministic: return typeid(par_deterministic); 
             case policy_type::vector: return typeid(par_vec); 
         }
         std::terminate();
@@ -203,6 +233,9 @@ private:
             case policy_type::parallel:
                 new (static_cast<void*>(&policy)) parallel_execution_policy;
                 break;
+            case policy_type::deterministic:
+                new (static_cast<void*>(&policy)) parallel_deterministic_execution_policy;
+                break;
             case policy_type::vector:
                 new (static_cast<void*>(&policy)) parallel_vector_execution_policy;
                 break;
@@ -222,6 +255,10 @@ private:
                 reinterpret_cast<parallel_execution_policy*>(&policy)->
                     ~parallel_execution_policy();
                 break;
+            case policy_type::deterministic:
+                reinterpret_cast<parallel_deterministic_execution_policy*>(&policy)->
+                    ~parallel_deterministic_execution_policy();
+                break;
             case policy_type::vector:
                 reinterpret_cast<parallel_vector_execution_policy*>(&policy)->
                     ~parallel_vector_execution_policy();
@@ -233,7 +270,7 @@ private:
 
     enum class policy_type 
         : std::uint8_t
-    { sequential, parallel, vector };
+    { sequential, parallel, deterministic, vector };
     
     policy_type which;
 
@@ -241,6 +278,7 @@ private:
         1,
         sequential_execution_policy, 
         parallel_execution_policy,
+        parallel_deterministic_execution_policy,
         parallel_vector_execution_policy
     > policy;
 
@@ -252,7 +290,9 @@ private:
                 ? policy_type::sequential 
                 : is_same_v<T, parallel_execution_policy> 
                     ? policy_type::parallel 
-                    : policy_type::vector;
+                    : is_same_v<T, parallel_deterministic_execution_policy> 
+                        ? policy_type::deterministic 
+                        : policy_type::vector;
     }
 };
 
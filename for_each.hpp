@@ -1,14 +1,19 @@
 #pragma once
 
 #include <algorithm>
-#include <future>
 #include <iterator>
 #include <thread>
 #include <type_traits>
 #include <vector>
 
+#include "cancellation.hpp"
 #include "execution_policy.hpp"
 #include "dispatch.hpp"
+#include "hardware_conc.hpp"
+#include "segmented.hpp"
+#include "streaming.hpp"
+#include "thread_pool.hpp"
+#include "zip_iterator.hpp"
 
 namespace experimental
 {
@@ -37,34 +42,21 @@ void for_each_impl(
             typename std::iterator_traits<InputIt>::iterator_category,
             std::random_access_iterator_tag
         >::value 
-    >::type* = 0
+    >::type* = 0,
+    enable_if_not_segmented<InputIt>* = 0
 )
 {
-    const static unsigned hc = 2 * get_hardware_concurrency_or_default();
-    const auto size = std::distance(begin, end);
-    const auto chunk_size = static_cast<std::size_t>(size) / hc;
-    std::vector<std::future<void>> tasks;
-
-    tasks.reserve(hc);
-    
-    for(auto i = 0U; i < hc; ++i) {
-        const unsigned i_chunk = i * chunk_size;
-        const unsigned next_i_chunk = i_chunk + chunk_size; 
-        tasks.emplace_back(
-            std::async(
-                std::launch::async,
-                [begin, i_chunk, next_i_chunk, f] { 
-                auto begin_chunk = begin + i_chunk;
-                auto end_chunk = begin + next_i_chunk;
-                while(begin_chunk != end_chunk) {
-                    f(*begin_chunk);
-                    ++begin_chunk; 
-                }
-            })
-        );
-    }
-
-    for(auto&& task : tasks) { task.get(); }
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+
+    for_each_chunk(size, [begin, f](std::size_t, std::size_t first, std::size_t last) {
+        auto begin_chunk = begin + first;
+        auto end_chunk = begin + last;
+        chunk_hint(begin_chunk, end_chunk);
+        while(begin_chunk != end_chunk) {
+            f(*begin_chunk);
+            ++begin_chunk; 
+        }
+    });
 }
 
 template <typename InputIt, typename Func>
@@ -75,10 +67,25 @@ void for_each_impl(
             typename std::iterator_traits<InputIt>::iterator_category,
             std::random_access_iterator_tag
         >::value 
-    >::type* = 0
+    >::type* = 0,
+    enable_if_not_segmented<InputIt>* = 0
 )
 {
-    std::for_each(begin, end, f);
+    stream_for_each(begin, end, [&f](auto&& x) { f(x); return true; });
+}
+
+// Segmented iterators (std::deque, flatten): chunks run over the local
+// iterators of each segment, see segmented.hpp.
+template <typename InputIt, typename Func>
+void for_each_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, Func f,
+    enable_if_segmented<InputIt>* = 0
+)
+{
+    const segment_chunks<InputIt> pieces(begin, end);
+    pieces.for_each_chunk([&f](std::size_t, auto first, auto last) {
+        for(; first != last; ++first) { f(*first); }
+    });
 }
 
 //================================================================================
@@ -91,6 +98,87 @@ void for_each_impl(
     for_each_impl(par, begin, end, f);
 }
 
+// Zipped contiguous arrays: every chunk indexes the raw arrays directly, see
+// zip_iterator.hpp.
+template <typename... Iterators, typename Func>
+void for_each_impl(
+    parallel_vector_execution_policy,
+    zip_iterator<Iterators...> begin, zip_iterator<Iterators...> end, Func f,
+    typename std::enable_if<is_contiguous_zip_v<zip_iterator<Iterators...>>>::type* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(end - begin);
+    if(size == 0) { return; }
+
+    const zip_pointers<Iterators...> arrays(begin);
+    for_each_chunk(size, [&arrays, &f](std::size_t, std::size_t first, std::size_t last) {
+        for(auto j = first; j != last; ++j) { f(arrays[j]); }
+    });
+}
+
+//================================================================================
+//=========================Cancellable Overloads==================================
+//================================================================================
+
+template <typename InputIt, typename Func>
+completion_status for_each_impl(
+    sequential_execution_policy, InputIt begin, InputIt end, Func f,
+    const cancellation_token& token
+)
+{
+    return cancellable_for_each(begin, end, token, f)
+        ? completion_status::completed
+        : completion_status::cancelled;
+}
+
+template <typename InputIt, typename Func>
+completion_status for_each_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, Func f,
+    const cancellation_token& token,
+    typename std::enable_if<
+        std::is_same<
+            typename std::iterator_traits<InputIt>::iterator_category,
+            std::random_access_iterator_tag
+        >::value 
+    >::type* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+
+    const bool completed = reduce_chunks(size, true,
+        [begin, f, &token](std::size_t first, std::size_t last) {
+            chunk_hint(begin + first, begin + last);
+            return cancellable_for_each(begin + first, begin + last, token, f);
+        },
+        [](bool a, bool b) { return a && b; });
+
+    return completed ? completion_status::completed : completion_status::cancelled;
+}
+
+template <typename InputIt, typename Func>
+completion_status for_each_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, Func f,
+    const cancellation_token& token,
+    typename std::enable_if<
+        !std::is_same<
+            typename std::iterator_traits<InputIt>::iterator_category,
+            std::random_access_iterator_tag
+        >::value 
+    >::type* = 0
+)
+{
+    return for_each_impl(seq, begin, end, f, token);
+}
+
+template <typename InputIt, typename Func>
+completion_status for_each_impl(
+    parallel_vector_execution_policy, InputIt begin, InputIt end, Func f,
+    const cancellation_token& token
+)
+{
+    return for_each_impl(par, begin, end, f, token);
+}
+
 //================================================================================
 
 } // end namespace internal
@@ -116,6 +204,29 @@ void for_each(
     return internal::dispatch(policy, f);
 }
 
+// Cancellable overloads: workers poll the token once per block of elements,
+// and stop early once it is cancelled or its deadline has passed.
+template <typename ExecutionPolicy, typename InputIt, typename Func>
+completion_status for_each(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, Func func,
+    const cancellation_token& token,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{ 
+    return internal::for_each_impl(policy, begin, end, func, token);
+}
+
+template <typename InputIt, typename Func>
+completion_status for_each(
+    execution_policy policy, InputIt begin, InputIt end, Func func,
+    const cancellation_token& token
+)
+{ 
+    auto f = [begin, end, func, &token](auto policy)
+             { return internal::for_each_impl(policy, begin, end, func, token); };
+    return internal::dispatch(policy, f);
+}
+
 } // end namespace parallel
 } // end namespace experimental
 
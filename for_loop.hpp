@@ -0,0 +1,447 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "reduce.hpp"
+#include "thread_pool.hpp"
+#include "zip_iterator.hpp"
+
+// Index-based loops, after for_loop in the Parallelism TS 2:
+//
+//     using namespace experimental::parallel;
+//     double sum = 0;
+//     float* out = results;
+//     for_loop(par, 0, n, reduction_plus(sum), induction(out),
+//         [&](int i, double& s, float* o) { s += x[i] * y[i]; *o = x[i]; });
+//
+// The loop variable runs from first (inclusive) to last (exclusive), or by
+// stride with for_loop_strided; first and last are either integers or random
+// access iterators. The last argument is the body; before it come any number
+// of reductions and inductions, and the body is called with the loop
+// variable followed by one argument for each of those, in order:
+//
+// - reduction(var, identity, op) passes a T& to a private accumulator that
+//   starts out as identity. Every chunk has its own, so the body doesn't need
+//   atomics; at the end they are folded into var with op, in chunk order.
+//   Under par_deterministic every block of deterministic_block_size
+//   iterations has its own, and they are combined pairwise along a fixed
+//   tree as in reduce, so the result doesn't depend on the thread count.
+//   reduction_plus, reduction_multiplies, reduction_bit_and/or/xor and
+//   reduction_min/max cover the usual cases.
+// - induction(var, stride) passes the value var + k * stride for the k-th
+//   iteration. If var is an lvalue, it is set to its value after the last
+//   iteration when the loop is done.
+//
+// The stride of for_loop_strided must not be zero.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+template <typename T>
+struct type_identity { using type = T; };
+
+template <typename T>
+using type_identity_t = typename type_identity<T>::type;
+
+template <typename T, typename BinaryOp>
+class reduction_object
+{
+public:
+
+    using private_type = T;
+
+    reduction_object(T& var, T identity, BinaryOp op)
+        : var(var), identity(std::move(identity)), op(std::move(op))
+    { }
+
+    private_type make_private() const { return identity; }
+
+    T& view(private_type& p, std::size_t) const { return p; }
+
+    private_type merge(private_type& a, private_type& b) { return op(std::move(a), std::move(b)); }
+
+    void combine(private_type& p) { var = op(std::move(var), std::move(p)); }
+
+    void finish(std::size_t) { }
+
+private:
+
+    T& var;
+    T identity;
+    BinaryOp op;
+};
+
+// Var is T& for inductions whose variable is written back, T otherwise.
+template <typename Var, typename Stride>
+class induction_object
+{
+public:
+
+    using value_type = std::decay_t<Var>;
+    struct private_type { };
+
+    induction_object(Var var, Stride stride)
+        : var(var), start(var), stride(stride)
+    { }
+
+    private_type make_private() const { return {}; }
+
+    value_type view(private_type&, std::size_t k) const { return value_at(k); }
+
+    private_type merge(private_type&, private_type&) { return {}; }
+
+    void combine(private_type&) { }
+
+    void finish(std::size_t count) { finish(count, std::is_reference<Var>{}); }
+
+private:
+
+    value_type value_at(std::size_t k) const
+    { return start + static_cast<Stride>(k) * stride; }
+
+    void finish(std::size_t count, std::true_type) { var = value_at(count); }
+    void finish(std::size_t, std::false_type) { }
+
+    Var var;
+    value_type start;
+    Stride stride;
+};
+
+template <typename T>
+struct is_loop_object : std::false_type { };
+
+template <typename T, typename BinaryOp>
+struct is_loop_object<reduction_object<T, BinaryOp>> : std::true_type { };
+
+template <typename Var, typename Stride>
+struct is_loop_object<induction_object<Var, Stride>> : std::true_type { };
+
+struct min_op
+{
+    template <typename T>
+    T operator()(const T& a, const T& b) const { return b < a ? b : a; }
+};
+
+struct max_op
+{
+    template <typename T>
+    T operator()(const T& a, const T& b) const { return a < b ? b : a; }
+};
+
+//================================================================================
+
+// Number of iterations from first to last by stride, and the loop variable
+// of iteration k.
+
+template <typename I, typename S>
+std::size_t loop_count(I first, I last, S stride, std::true_type /* integral */)
+{
+    if(stride > 0) {
+        return last > first
+            ? (static_cast<std::size_t>(last - first) + static_cast<std::size_t>(stride) - 1)
+                  / static_cast<std::size_t>(stride)
+            : 0;
+    }
+    return first > last
+        ? (static_cast<std::size_t>(first - last) + static_cast<std::size_t>(-stride) - 1)
+              / static_cast<std::size_t>(-stride)
+        : 0;
+}
+
+template <typename I, typename S>
+std::size_t loop_count(I first, I last, S stride, std::false_type /* iterator */)
+{
+    const auto distance = last - first;
+    using difference_type = decltype(distance);
+    return loop_count(difference_type(0), distance, static_cast<difference_type>(stride),
+                      std::true_type{});
+}
+
+template <typename I, typename S>
+I loop_index(I first, std::size_t k, S stride, std::true_type /* integral */)
+{
+    return static_cast<I>(first + static_cast<I>(static_cast<S>(k) * stride));
+}
+
+template <typename I, typename S>
+I loop_index(I first, std::size_t k, S stride, std::false_type /* iterator */)
+{
+    using difference_type = typename std::iterator_traits<I>::difference_type;
+    return first + static_cast<difference_type>(k) * static_cast<difference_type>(stride);
+}
+
+//================================================================================
+
+template <typename... Objects>
+using loop_privates = std::tuple<typename Objects::private_type...>;
+
+template <typename... Objects, std::size_t... Is>
+loop_privates<Objects...> make_privates(
+    const std::tuple<Objects...>& objects, std::index_sequence<Is...>
+)
+{
+    return loop_privates<Objects...>(std::get<Is>(objects).make_private()...);
+}
+
+// Runs iterations [first, last) with the given private state.
+template <typename I, typename S, typename Func, typename... Objects, std::size_t... Is>
+void run_iterations(
+    I start, S stride, Func& f, const std::tuple<Objects...>& objects,
+    loop_privates<Objects...>& privates, std::size_t first, std::size_t last,
+    std::index_sequence<Is...>
+)
+{
+    using is_integral = typename std::is_integral<I>::type;
+    for(auto k = first; k != last; ++k) {
+        f(loop_index(start, k, stride, is_integral{}),
+          std::get<Is>(objects).view(std::get<Is>(privates), k)...);
+    }
+}
+
+template <typename... Objects, std::size_t... Is>
+loop_privates<Objects...> merge_privates(
+    std::tuple<Objects...>& objects, loop_privates<Objects...>& a,
+    loop_privates<Objects...>& b, std::index_sequence<Is...>
+)
+{
+    return loop_privates<Objects...>(
+        std::get<Is>(objects).merge(std::get<Is>(a), std::get<Is>(b))...);
+}
+
+template <typename... Objects, std::size_t... Is>
+void combine_privates(
+    std::tuple<Objects...>& objects, loop_privates<Objects...>& privates,
+    std::index_sequence<Is...>
+)
+{
+    using expand = int[];
+    (void)expand{ 0, (std::get<Is>(objects).combine(std::get<Is>(privates)), 0)... };
+}
+
+template <typename... Objects, std::size_t... Is>
+void finish_objects(
+    std::tuple<Objects...>& objects, std::size_t count, std::index_sequence<Is...>
+)
+{
+    using expand = int[];
+    (void)expand{ 0, (std::get<Is>(objects).finish(count), 0)... };
+}
+
+//================================================================================
+
+template <typename I, typename S, typename Func, typename... Objects>
+void for_loop_impl(
+    sequential_execution_policy, I start, std::size_t count, S stride, Func& f,
+    std::tuple<Objects...>& objects
+)
+{
+    constexpr auto is = std::index_sequence_for<Objects...>{};
+    auto privates = make_privates(objects, is);
+    run_iterations(start, stride, f, objects, privates, 0, count, is);
+    combine_privates(objects, privates, is);
+    finish_objects(objects, count, is);
+}
+
+template <typename I, typename S, typename Func, typename... Objects>
+void for_loop_impl(
+    parallel_execution_policy, I start, std::size_t count, S stride, Func& f,
+    std::tuple<Objects...>& objects
+)
+{
+    constexpr auto is = std::index_sequence_for<Objects...>{};
+    if(count == 0) {
+        finish_objects(objects, 0, is);
+        return;
+    }
+
+    struct slot { loop_privates<Objects...> value; };
+    const auto n = chunk_count(count);
+    inline_buffer<slot, inline_slots<slot>> partial(n);
+    for(std::size_t i = 0; i < n; ++i) { partial.emplace_back(slot{make_privates(objects, is)}); }
+
+    for_each_chunk(count, n,
+        [start, stride, &f, &objects, &partial, is](std::size_t i, std::size_t first, std::size_t last) {
+            run_iterations(start, stride, f, objects, partial[i].value, first, last, is);
+        });
+
+    for(auto&& p : partial) { combine_privates(objects, p.value, is); }
+    finish_objects(objects, count, is);
+}
+
+// Blocks are independent of the chunking, so they are grouped into chunks
+// only to spread them over the pool.
+template <typename I, typename S, typename Func, typename... Objects>
+void for_loop_impl(
+    parallel_deterministic_execution_policy, I start, std::size_t count, S stride, Func& f,
+    std::tuple<Objects...>& objects
+)
+{
+    constexpr auto is = std::index_sequence_for<Objects...>{};
+    if(count == 0) {
+        finish_objects(objects, 0, is);
+        return;
+    }
+
+    const auto blocks = (count + deterministic_block_size - 1) / deterministic_block_size;
+    std::vector<loop_privates<Objects...>> partial;
+    partial.reserve(blocks);
+    for(std::size_t b = 0; b < blocks; ++b) { partial.push_back(make_privates(objects, is)); }
+
+    for_each_chunk(blocks,
+        [start, stride, count, &f, &objects, &partial, is](std::size_t, std::size_t first, std::size_t last) {
+            for(auto b = first; b != last; ++b) {
+                run_iterations(start, stride, f, objects, partial[b],
+                               b * deterministic_block_size,
+                               std::min(count, (b + 1) * deterministic_block_size), is);
+            }
+        });
+
+    auto merge = [&objects, is](loop_privates<Objects...>&& a, loop_privates<Objects...>&& b)
+                 { return merge_privates(objects, a, b, is); };
+    auto total = fold_pairwise(partial, merge);
+    combine_privates(objects, total, is);
+    finish_objects(objects, count, is);
+}
+
+template <typename I, typename S, typename Func, typename... Objects>
+void for_loop_impl(
+    parallel_vector_execution_policy, I start, std::size_t count, S stride, Func& f,
+    std::tuple<Objects...>& objects
+)
+{
+    for_loop_impl(par, start, count, stride, f, objects);
+}
+
+//================================================================================
+
+// Splits args into the loop objects and the body (the last argument), and
+// runs the loop.
+template <typename Policy, typename I, typename S, typename Args, std::size_t... Is>
+void for_loop_entry(
+    Policy policy, I first, I last, S stride, Args& args, std::index_sequence<Is...>
+)
+{
+    auto objects = std::make_tuple(std::get<Is>(args)...);
+    static_assert(all_true<is_loop_object<std::decay_t<std::tuple_element_t<Is, Args>>>::value...>::value,
+                  "the arguments before the body must be reductions or inductions");
+    auto& f = std::get<sizeof...(Is)>(args);
+
+    const auto count = loop_count(first, last, stride, typename std::is_integral<I>::type{});
+    for_loop_impl(policy, first, count, stride, f, objects);
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename T, typename BinaryOp>
+internal::reduction_object<T, BinaryOp> reduction(T& var, const T& identity, BinaryOp op)
+{ return { var, identity, op }; }
+
+template <typename T>
+internal::reduction_object<T, std::plus<T>> reduction_plus(T& var)
+{ return { var, T(), std::plus<T>{} }; }
+
+template <typename T>
+internal::reduction_object<T, std::multiplies<T>> reduction_multiplies(T& var)
+{ return { var, T(1), std::multiplies<T>{} }; }
+
+template <typename T>
+internal::reduction_object<T, std::bit_and<T>> reduction_bit_and(T& var)
+{ return { var, ~T(), std::bit_and<T>{} }; }
+
+template <typename T>
+internal::reduction_object<T, std::bit_or<T>> reduction_bit_or(T& var)
+{ return { var, T(), std::bit_or<T>{} }; }
+
+template <typename T>
+internal::reduction_object<T, std::bit_xor<T>> reduction_bit_xor(T& var)
+{ return { var, T(), std::bit_xor<T>{} }; }
+
+// The identity of min and max is the variable's own value, which every
+// private accumulator starts out with.
+template <typename T>
+internal::reduction_object<T, internal::min_op> reduction_min(T& var)
+{ return { var, var, internal::min_op{} }; }
+
+template <typename T>
+internal::reduction_object<T, internal::max_op> reduction_max(T& var)
+{ return { var, var, internal::max_op{} }; }
+
+template <typename T>
+internal::induction_object<T, std::ptrdiff_t> induction(T&& var)
+{ return { std::forward<T>(var), 1 }; }
+
+template <typename T, typename Stride>
+internal::induction_object<T, Stride> induction(T&& var, Stride stride)
+{ return { std::forward<T>(var), stride }; }
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename I, typename... Args>
+typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type
+for_loop(
+    ExecutionPolicy&& policy, I first, internal::type_identity_t<I> last, Args&&... args
+)
+{
+    auto all = std::forward_as_tuple(std::forward<Args>(args)...);
+    internal::for_loop_entry(policy, first, last, std::ptrdiff_t(1), all,
+                             std::make_index_sequence<sizeof...(Args) - 1>{});
+}
+
+template <typename I, typename... Args>
+void for_loop(
+    execution_policy policy, I first, internal::type_identity_t<I> last, Args&&... args
+)
+{
+    auto all = std::forward_as_tuple(std::forward<Args>(args)...);
+    auto f = [first, last, &all](auto policy) {
+        internal::for_loop_entry(policy, first, last, std::ptrdiff_t(1), all,
+                                 std::make_index_sequence<sizeof...(Args) - 1>{});
+    };
+    internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename I, typename S, typename... Args>
+typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type
+for_loop_strided(
+    ExecutionPolicy&& policy, I first, internal::type_identity_t<I> last, S stride,
+    Args&&... args
+)
+{
+    auto all = std::forward_as_tuple(std::forward<Args>(args)...);
+    internal::for_loop_entry(policy, first, last, stride, all,
+                             std::make_index_sequence<sizeof...(Args) - 1>{});
+}
+
+template <typename I, typename S, typename... Args>
+void for_loop_strided(
+    execution_policy policy, I first, internal::type_identity_t<I> last, S stride,
+    Args&&... args
+)
+{
+    auto all = std::forward_as_tuple(std::forward<Args>(args)...);
+    auto f = [first, last, stride, &all](auto policy) {
+        internal::for_loop_entry(policy, first, last, stride, all,
+                                 std::make_index_sequence<sizeof...(Args) - 1>{});
+    };
+    internal::dispatch(policy, f);
+}
+
+} // end namespace parallel
+} // end namespace experimental
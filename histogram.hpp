@@ -0,0 +1,380 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "count.hpp"
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "thread_pool.hpp"
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+constexpr std::size_t cache_line_size = 64;
+
+// Under par_vec, histograms with at most this many bins are built with
+// several interleaved sub-histograms per worker (see histogram_chunk_lanes).
+constexpr std::size_t vector_histogram_max_bins = 256;
+constexpr std::size_t vector_histogram_lanes = 8;
+
+template <typename InputIt>
+using histogram_type =
+    std::vector<typename std::iterator_traits<InputIt>::difference_type>;
+
+template <typename InputIt, typename KeyFn>
+using key_type_t =
+    std::decay_t<decltype(std::declval<KeyFn&>()(*std::declval<InputIt>()))>;
+
+template <typename InputIt, typename KeyFn>
+using count_by_key_type =
+    std::unordered_map<
+        key_type_t<InputIt, KeyFn>,
+        typename std::iterator_traits<InputIt>::difference_type
+    >;
+
+struct identity_key
+{
+    template <typename T>
+    const T& operator()(const T& v) const { return v; }
+};
+
+// Counters padded out to a whole number of cache lines, so that the private
+// bins of two workers never share a line.
+template <typename Counter>
+std::size_t padded_bins(std::size_t bins)
+{
+    constexpr std::size_t per_line = cache_line_size / sizeof(Counter);
+    return (bins + per_line - 1) / per_line * per_line;
+}
+
+// The default allocator only guarantees alignof(max_align_t), so over-allocate
+// by a line and start the bins on the first line boundary.
+template <typename Counter>
+Counter* align_to_cache_line(std::vector<Counter>& storage)
+{
+    const auto addr = reinterpret_cast<std::uintptr_t>(storage.data());
+    const auto aligned = (addr + cache_line_size - 1) & ~(cache_line_size - 1);
+    return reinterpret_cast<Counter*>(aligned);
+}
+
+//================================================================================
+
+template <typename InputIt, typename KeyFn, typename Counter>
+void histogram_chunk(
+    InputIt begin, InputIt end, KeyFn& key, std::size_t bins, Counter* out
+)
+{
+    for(; begin != end; ++begin) {
+        const auto k = static_cast<std::size_t>(key(*begin));
+        if(k < bins) { ++out[k]; }
+    }
+}
+
+// Consecutive elements update different sub-histograms, so runs of equal keys
+// don't serialize on the same counter and the key computations of a group
+// of lanes are independent of each other.
+template <typename InputIt, typename KeyFn, typename Counter>
+void histogram_chunk_lanes(
+    InputIt begin, InputIt end, KeyFn& key, std::size_t bins, Counter* out
+)
+{
+    constexpr std::size_t lanes = vector_histogram_lanes;
+    std::array<std::array<Counter, vector_histogram_max_bins>, lanes> sub{};
+    std::array<std::size_t, lanes> k;
+
+    auto size = static_cast<std::size_t>(std::distance(begin, end));
+    for(; size >= lanes; size -= lanes, begin += lanes) {
+        for(std::size_t l = 0; l < lanes; ++l) {
+            k[l] = static_cast<std::size_t>(key(begin[l]));
+        }
+        for(std::size_t l = 0; l < lanes; ++l) {
+            if(k[l] < bins) { ++sub[l][k[l]]; }
+        }
+    }
+    histogram_chunk(begin, end, key, bins, sub[0].data());
+
+    for(std::size_t b = 0; b < bins; ++b) {
+        Counter total{0};
+        for(std::size_t l = 0; l < lanes; ++l) { total += sub[l][b]; }
+        out[b] += total;
+    }
+}
+
+//================================================================================
+//=======================Sequential Execution Policy==============================
+//================================================================================
+
+template <typename InputIt, typename KeyFn>
+histogram_type<InputIt> histogram_impl(
+    sequential_execution_policy, InputIt begin, InputIt end,
+    std::size_t bins, KeyFn key
+)
+{
+    histogram_type<InputIt> result(bins);
+    histogram_chunk(begin, end, key, bins, result.data());
+    return result;
+}
+
+template <typename InputIt, typename KeyFn>
+count_by_key_type<InputIt, KeyFn> count_by_key_impl(
+    sequential_execution_policy, InputIt begin, InputIt end, KeyFn key
+)
+{
+    count_by_key_type<InputIt, KeyFn> result;
+    for(; begin != end; ++begin) { ++result[key(*begin)]; }
+    return result;
+}
+
+//================================================================================
+//========================Parallel Execution Policy===============================
+//================================================================================
+
+// Every chunk counts into its own privatized, cache line aligned bins. The
+// bins are then split into slices and each slice is summed over all chunks
+// by a separate task, so neither phase needs atomics.
+template <typename InputIt, typename KeyFn, typename ChunkFn>
+histogram_type<InputIt> histogram_base(
+    InputIt begin, InputIt end, std::size_t bins, KeyFn key, ChunkFn chunk_fn
+)
+{
+    using counter = typename histogram_type<InputIt>::value_type;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    const auto chunks = chunk_count(size);
+    const auto stride = padded_bins<counter>(bins);
+
+    std::vector<counter> storage(
+        chunks * stride + cache_line_size / sizeof(counter), counter{0}
+    );
+    counter* const private_bins = align_to_cache_line(storage);
+
+    for_each_chunk(size,
+        [begin, &key, bins, private_bins, stride, &chunk_fn]
+        (std::size_t i, std::size_t first, std::size_t last) {
+            KeyFn k = key;
+            chunk_fn(begin + first, begin + last, k, bins, private_bins + i * stride);
+        });
+
+    histogram_type<InputIt> result(bins);
+    for_each_chunk(bins,
+        [chunks, private_bins, stride, &result]
+        (std::size_t, std::size_t first, std::size_t last) {
+            for(std::size_t i = 0; i < chunks; ++i) {
+                const counter* in = private_bins + i * stride;
+                for(auto b = first; b != last; ++b) { result[b] += in[b]; }
+            }
+        });
+    return result;
+}
+
+template <typename InputIt, typename KeyFn>
+histogram_type<InputIt> histogram_impl(
+    parallel_execution_policy, InputIt begin, InputIt end,
+    std::size_t bins, KeyFn key, enable_if_random<InputIt>* = 0
+)
+{
+    return histogram_base(begin, end, bins, key,
+        [](InputIt b, InputIt e, KeyFn& k, std::size_t n, auto* out)
+        { histogram_chunk(b, e, k, n, out); });
+}
+
+template <typename InputIt, typename KeyFn>
+histogram_type<InputIt> histogram_impl(
+    parallel_execution_policy, InputIt begin, InputIt end,
+    std::size_t bins, KeyFn key, enable_if_not_random<InputIt>* = 0
+)
+{
+    return histogram_impl(seq, begin, end, bins, key);
+}
+
+//--------------------------------------------------------------------------------
+
+// Each chunk counts into one private map per hash partition. Partition p of
+// every chunk is then merged by its own task, and since partitions hold
+// disjoint keys the merged partitions are simply concatenated.
+template <typename InputIt, typename KeyFn>
+count_by_key_type<InputIt, KeyFn> count_by_key_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, KeyFn key,
+    enable_if_random<InputIt>* = 0
+)
+{
+    using map_type = count_by_key_type<InputIt, KeyFn>;
+    using key_type = key_type_t<InputIt, KeyFn>;
+    using partitions = std::vector<map_type>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    const auto chunks = chunk_count(size);
+    std::vector<partitions> chunk_parts(chunks, partitions(chunks));
+
+    for_each_chunk(size,
+        [begin, &key, &chunk_parts](std::size_t i, std::size_t first, std::size_t last) {
+            KeyFn k = key;
+            partitions& parts = chunk_parts[i];
+            const std::hash<key_type> hasher{};
+            for(auto it = begin + first; it != begin + last; ++it) {
+                auto&& x = k(*it);
+                ++parts[hasher(x) % parts.size()][x];
+            }
+        });
+
+    partitions merged(chunks);
+    for_each_chunk(chunks,
+        [chunks, &chunk_parts, &merged](std::size_t, std::size_t first, std::size_t last) {
+            for(auto p = first; p != last; ++p) {
+                merged[p] = std::move(chunk_parts[0][p]);
+                for(std::size_t i = 1; i < chunks; ++i) {
+                    for(auto&& kv : chunk_parts[i][p]) { merged[p][kv.first] += kv.second; }
+                }
+            }
+        });
+
+    map_type result;
+    for(auto&& part : merged) { result.insert(part.begin(), part.end()); }
+    return result;
+}
+
+template <typename InputIt, typename KeyFn>
+count_by_key_type<InputIt, KeyFn> count_by_key_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, KeyFn key,
+    enable_if_not_random<InputIt>* = 0
+)
+{
+    return count_by_key_impl(seq, begin, end, key);
+}
+
+//================================================================================
+//=====================Parallel Vector Execution Policy===========================
+//================================================================================
+
+template <typename InputIt, typename KeyFn>
+histogram_type<InputIt> histogram_impl(
+    parallel_vector_execution_policy, InputIt begin, InputIt end,
+    std::size_t bins, KeyFn key, enable_if_random<InputIt>* = 0
+)
+{
+    if(bins > vector_histogram_max_bins) {
+        return histogram_impl(par, begin, end, bins, key);
+    }
+    return histogram_base(begin, end, bins, key,
+        [](InputIt b, InputIt e, KeyFn& k, std::size_t n, auto* out)
+        { histogram_chunk_lanes(b, e, k, n, out); });
+}
+
+template <typename InputIt, typename KeyFn>
+histogram_type<InputIt> histogram_impl(
+    parallel_vector_execution_policy, InputIt begin, InputIt end,
+    std::size_t bins, KeyFn key, enable_if_not_random<InputIt>* = 0
+)
+{
+    return histogram_impl(seq, begin, end, bins, key);
+}
+
+template <typename InputIt, typename KeyFn>
+count_by_key_type<InputIt, KeyFn> count_by_key_impl(
+    parallel_vector_execution_policy, InputIt begin, InputIt end, KeyFn key
+)
+{
+    return count_by_key_impl(par, begin, end, key);
+}
+
+} // end namespace internal
+
+//================================================================================
+
+// Dense histogram: bin i counts the elements whose key is i. Elements with a
+// key outside [0, bins) are ignored.
+template <typename ExecutionPolicy, typename InputIt, typename KeyFn>
+internal::histogram_type<InputIt> histogram(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end,
+    std::size_t bins, KeyFn key,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::histogram_impl(policy, begin, end, bins, key);
+}
+
+template <typename ExecutionPolicy, typename InputIt>
+internal::histogram_type<InputIt> histogram(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, std::size_t bins,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::histogram_impl(policy, begin, end, bins, internal::identity_key{});
+}
+
+template <typename InputIt, typename KeyFn>
+internal::histogram_type<InputIt> histogram(
+    execution_policy policy, InputIt begin, InputIt end,
+    std::size_t bins, KeyFn key
+)
+{
+    auto func = [begin, end, bins, key](auto policy)
+                { return internal::histogram_impl(policy, begin, end, bins, key); };
+    return internal::dispatch(policy, func);
+}
+
+template <typename InputIt>
+internal::histogram_type<InputIt> histogram(
+    execution_policy policy, InputIt begin, InputIt end, std::size_t bins
+)
+{
+    return histogram(policy, begin, end, bins, internal::identity_key{});
+}
+
+//--------------------------------------------------------------------------------
+
+// Sparse counterpart of histogram for keys that are hashable rather than
+// small integers.
+template <typename ExecutionPolicy, typename InputIt, typename KeyFn>
+internal::count_by_key_type<InputIt, KeyFn> count_by_key(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, KeyFn key,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::count_by_key_impl(policy, begin, end, key);
+}
+
+template <typename ExecutionPolicy, typename InputIt>
+internal::count_by_key_type<InputIt, internal::identity_key> count_by_key(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::count_by_key_impl(policy, begin, end, internal::identity_key{});
+}
+
+template <typename InputIt, typename KeyFn>
+internal::count_by_key_type<InputIt, KeyFn> count_by_key(
+    execution_policy policy, InputIt begin, InputIt end, KeyFn key
+)
+{
+    auto func = [begin, end, key](auto policy)
+                { return internal::count_by_key_impl(policy, begin, end, key); };
+    return internal::dispatch(policy, func);
+}
+
+template <typename InputIt>
+internal::count_by_key_type<InputIt, internal::identity_key> count_by_key(
+    execution_policy policy, InputIt begin, InputIt end
+)
+{
+    return count_by_key(policy, begin, end, internal::identity_key{});
+}
+
+} // end namespace parallel
+} // end namespace experimental
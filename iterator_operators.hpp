@@ -0,0 +1,56 @@
+#pragma once
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+// CRTP helper providing the full set of random access operators in terms of
+// Derived::advance(n), Derived::distance_to(other) and Derived::equal(other).
+// Equality doesn't go through distance_to so that adaptors over forward
+// iterators can still be compared in constant time.
+template <typename Derived, typename Difference>
+class random_access_operators
+{
+public:
+
+    Derived& operator++() { self().advance(1); return self(); }
+    Derived& operator--() { self().advance(-1); return self(); }
+    Derived operator++(int) { Derived t = self(); self().advance(1); return t; }
+    Derived operator--(int) { Derived t = self(); self().advance(-1); return t; }
+
+    Derived& operator+=(Difference n) { self().advance(n); return self(); }
+    Derived& operator-=(Difference n) { self().advance(-n); return self(); }
+
+    friend Derived operator+(Derived it, Difference n) { it.advance(n); return it; }
+    friend Derived operator+(Difference n, Derived it) { it.advance(n); return it; }
+    friend Derived operator-(Derived it, Difference n) { it.advance(-n); return it; }
+
+    friend Difference operator-(const Derived& a, const Derived& b)
+    { return b.distance_to(a); }
+
+    friend bool operator==(const Derived& a, const Derived& b)
+    { return a.equal(b); }
+    friend bool operator!=(const Derived& a, const Derived& b)
+    { return !a.equal(b); }
+    friend bool operator<(const Derived& a, const Derived& b)
+    { return a.distance_to(b) > 0; }
+    friend bool operator>(const Derived& a, const Derived& b)
+    { return b < a; }
+    friend bool operator<=(const Derived& a, const Derived& b)
+    { return !(b < a); }
+    friend bool operator>=(const Derived& a, const Derived& b)
+    { return !(a < b); }
+
+private:
+
+    Derived& self() { return static_cast<Derived&>(*this); }
+};
+
+} // end namespace internal
+} // end namespace parallel
+} // end namespace experimental
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "contiguous_iterator.hpp"
+#include "iterator_operators.hpp"
+
+// Read-only memory-mapped files that can be handed straight to the
+// algorithms, e.g. to count newlines in a log file without reading it into
+// a buffer first:
+//
+//     mapped_range file("app.log");
+//     auto lines = count(par, file.begin(), file.end(), '\n');
+//
+// The iterators are random access over contiguous memory, so every policy
+// takes its usual chunked path. The whole mapping is advised as sequential,
+// and the algorithms call chunk_hint() on every chunk, which asks the kernel
+// to start reading that chunk in (MADV_WILLNEED) before the worker faults on
+// it. This is POSIX only.
+
+namespace experimental
+{
+namespace parallel
+{
+
+//================================================================================
+
+template <typename T>
+class mapped_iterator
+    : public internal::random_access_operators<mapped_iterator<T>, std::ptrdiff_t>
+{
+public:
+
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_cv_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using reference = const T&;
+    using pointer = const T*;
+
+    mapped_iterator() = default;
+
+    explicit mapped_iterator(const T* p)
+        : p(p)
+    { }
+
+    reference operator*() const { return *p; }
+    pointer operator->() const { return p; }
+    reference operator[](difference_type n) const { return p[n]; }
+
+    pointer get() const { return p; }
+
+    void advance(difference_type n) { p += n; }
+    difference_type distance_to(const mapped_iterator& other) const
+    { return other.p - p; }
+    bool equal(const mapped_iterator& other) const
+    { return p == other.p; }
+
+private:
+
+    const T* p = nullptr;
+};
+
+// Found by argument dependent lookup from the algorithms' chunk loops.
+template <typename T>
+void chunk_hint(mapped_iterator<T> first, mapped_iterator<T> last) noexcept
+{
+    if(first == last) { return; }
+    static const auto page = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+    const auto begin = reinterpret_cast<std::uintptr_t>(first.get()) & ~(page - 1);
+    const auto end = reinterpret_cast<std::uintptr_t>(last.get());
+    // Purely advisory, so failures are ignored.
+    (void)::madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+}
+
+namespace internal
+{
+
+template <typename T>
+struct is_contiguous_iterator<mapped_iterator<T>>
+    : std::integral_constant<bool, true>
+{ };
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename T>
+class basic_mapped_range
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "mapped ranges can only hold trivially copyable types");
+
+public:
+
+    using value_type = T;
+    using iterator = mapped_iterator<T>;
+    using const_iterator = iterator;
+    using size_type = std::size_t;
+
+    // Maps the whole file read-only. Any trailing bytes that don't make up a
+    // whole T are not part of the range.
+    explicit basic_mapped_range(const std::string& path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) { throw_errno("open"); }
+
+        struct stat st;
+        if(::fstat(fd, &st) != 0) {
+            const int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "fstat");
+        }
+
+        bytes = static_cast<std::size_t>(st.st_size);
+        if(bytes > 0) {
+            void* addr = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(addr == MAP_FAILED) {
+                const int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "mmap");
+            }
+            mapping = addr;
+            (void)::madvise(mapping, bytes, MADV_SEQUENTIAL);
+        }
+        // The mapping stays valid once the descriptor is closed.
+        ::close(fd);
+    }
+
+    basic_mapped_range(basic_mapped_range&& other) noexcept
+        : mapping(other.mapping), bytes(other.bytes)
+    {
+        other.mapping = nullptr;
+        other.bytes = 0;
+    }
+
+    basic_mapped_range& operator=(basic_mapped_range&& other) noexcept
+    {
+        if(&other != this) {
+            unmap();
+            mapping = std::exchange(other.mapping, nullptr);
+            bytes = std::exchange(other.bytes, 0);
+        }
+        return *this;
+    }
+
+    basic_mapped_range(const basic_mapped_range&) = delete;
+    basic_mapped_range& operator=(const basic_mapped_range&) = delete;
+
+    ~basic_mapped_range()
+    {
+        unmap();
+    }
+
+    const T* data() const noexcept { return static_cast<const T*>(mapping); }
+    size_type size() const noexcept { return bytes / sizeof(T); }
+    bool empty() const noexcept { return size() == 0; }
+
+    iterator begin() const noexcept { return iterator(data()); }
+    iterator end() const noexcept { return iterator(data() + size()); }
+
+private:
+
+    [[noreturn]] static void throw_errno(const char* what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    void unmap() noexcept
+    {
+        if(mapping) { ::munmap(mapping, bytes); }
+    }
+
+    void* mapping = nullptr;
+    std::size_t bytes = 0;
+};
+
+using mapped_range = basic_mapped_range<char>;
+
+} // end namespace parallel
+} // end namespace experimental
@@ -0,0 +1,843 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "count.hpp"
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "thread_pool.hpp"
+#include "uninitialized.hpp"
+
+// Merges and set operations on sorted ranges:
+//
+//     using namespace experimental::parallel;
+//     merge(par, a.begin(), a.end(), b.begin(), b.end(), out.begin());
+//     auto end = set_intersection(par_vec, ids1.begin(), ids1.end(),
+//                                 ids2.begin(), ids2.end(), common.begin());
+//
+// The work is split with merge path partitioning: chunk i of the output of
+// merging the two inputs starts at a position d along the merge ("diagonal"),
+// and a binary search over the inputs finds how many of the first d elements
+// come from each. The chunks then merge their shares independently, so they
+// get equal shares of the inputs and need no coordination beyond those
+// searches. merge does all the searches before any chunk starts, so that it
+// can move from its inputs.
+//
+// The set operations move every split back to the start of the run of
+// equivalent elements it falls into, so a run is never shared between
+// chunks. As their output sizes are not known up front, they make two
+// passes: the first counts every chunk's output, the second writes it at the
+// offsets found by a prefix sum over the counts. Under par_vec,
+// set_intersection of integer lists ordered by std::less uses a kernel that
+// advances through the two lists without branching on which one to advance.
+//
+// The parallel paths need random access inputs and output; other iterators
+// are handled sequentially. inplace_merge merges through a temporary buffer,
+// and falls back to std::inplace_merge if the buffer can't be allocated.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+template <typename Iterator1, typename Iterator2, typename OutputIt>
+constexpr bool is_random_merge_v =
+    is_random_iterator_v<Iterator1> && is_random_iterator_v<Iterator2> &&
+    is_random_iterator_v<OutputIt>;
+
+template <typename Iterator1, typename Iterator2, typename OutputIt>
+using enable_if_random_merge =
+    typename std::enable_if<is_random_merge_v<Iterator1, Iterator2, OutputIt>>::type;
+
+template <typename Iterator1, typename Iterator2, typename OutputIt>
+using enable_if_not_random_merge =
+    typename std::enable_if<!is_random_merge_v<Iterator1, Iterator2, OutputIt>>::type;
+
+// Positions in the two inputs.
+struct merge_split
+{
+    std::size_t first;
+    std::size_t second;
+};
+
+// Where diagonal d crosses the merge of [a, a + size1) and [b, b + size2):
+// the first d elements of the merge are a[0, first) and b[0, second).
+// Equivalent elements are taken from a first, as std::merge does.
+template <typename RandomIt1, typename RandomIt2, typename Compare>
+merge_split merge_path(
+    RandomIt1 a, std::size_t size1, RandomIt2 b, std::size_t size2, std::size_t d,
+    Compare& comp
+)
+{
+    auto lo = d > size2 ? d - size2 : 0;
+    auto hi = std::min(d, size1);
+    while(lo < hi) {
+        const auto mid = lo + (hi - lo) / 2;
+        if(!comp(b[d - mid - 1], a[mid])) { lo = mid + 1; }
+        else { hi = mid; }
+    }
+    return { lo, d - lo };
+}
+
+// Like merge_path, moved back to the start of the run of elements
+// equivalent to the next element of the merge.
+template <typename RandomIt1, typename RandomIt2, typename Compare>
+merge_split set_path(
+    RandomIt1 a, std::size_t size1, RandomIt2 b, std::size_t size2, std::size_t d,
+    Compare& comp
+)
+{
+    auto split = merge_path(a, size1, b, size2, d, comp);
+    if(split.first == size1 && split.second == size2) { return split; }
+
+    // Everything before the split is at most the next element, so the run
+    // starts within the prefixes.
+    const bool from_first =
+        split.first < size1 && (split.second == size2 || !comp(b[split.second], a[split.first]));
+    const auto& next = from_first ? a[split.first] : b[split.second];
+    split.first = static_cast<std::size_t>(std::lower_bound(a, a + split.first, next, comp) - a);
+    split.second = static_cast<std::size_t>(std::lower_bound(b, b + split.second, next, comp) - b);
+    return split;
+}
+
+// Output iterator that only counts what is written to it.
+class counting_output_iterator
+{
+public:
+
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    counting_output_iterator& operator*() { return *this; }
+
+    template <typename T>
+    counting_output_iterator& operator=(const T&) { return *this; }
+
+    counting_output_iterator& operator++() { ++n; return *this; }
+    counting_output_iterator operator++(int) { auto old = *this; ++n; return old; }
+
+    std::size_t count() const { return n; }
+
+private:
+
+    std::size_t n = 0;
+};
+
+//================================================================================
+
+template <typename Iterator1, typename Iterator2, typename Compare>
+constexpr bool is_integer_intersection_v =
+    std::is_integral<iter_value_t<Iterator1>>::value &&
+    std::is_same<iter_value_t<Iterator1>, iter_value_t<Iterator2>>::value &&
+    (std::is_same<Compare, std::less<>>::value ||
+     std::is_same<Compare, std::less<iter_value_t<Iterator1>>>::value);
+
+// The usual intersection loop branches on which list holds the smaller
+// element, which is unpredictable on interleaved lists. Here both lists step
+// by the result of a comparison instead, and only the (rarer) match
+// branches.
+template <typename RandomIt1, typename RandomIt2, typename OutputIt>
+OutputIt branchless_intersection(
+    RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, RandomIt2 last2, OutputIt out
+)
+{
+    while(first1 != last1 && first2 != last2) {
+        const auto a = *first1;
+        const auto b = *first2;
+        if(a == b) { *out = a; ++out; }
+        first1 += !(b < a);
+        first2 += !(a < b);
+    }
+    return out;
+}
+
+struct set_union_op
+{
+    template <typename It1, typename It2, typename OutputIt, typename Compare>
+    OutputIt operator()(It1 first1, It1 last1, It2 first2, It2 last2, OutputIt out, Compare& comp) const
+    { return std::set_union(first1, last1, first2, last2, out, comp); }
+};
+
+struct set_intersection_op
+{
+    template <typename It1, typename It2, typename OutputIt, typename Compare>
+    OutputIt operator()(It1 first1, It1 last1, It2 first2, It2 last2, OutputIt out, Compare& comp) const
+    { return std::set_intersection(first1, last1, first2, last2, out, comp); }
+};
+
+struct branchless_intersection_op
+{
+    template <typename It1, typename It2, typename OutputIt, typename Compare>
+    OutputIt operator()(It1 first1, It1 last1, It2 first2, It2 last2, OutputIt out, Compare&) const
+    { return branchless_intersection(first1, last1, first2, last2, out); }
+};
+
+struct set_difference_op
+{
+    template <typename It1, typename It2, typename OutputIt, typename Compare>
+    OutputIt operator()(It1 first1, It1 last1, It2 first2, It2 last2, OutputIt out, Compare& comp) const
+    { return std::set_difference(first1, last1, first2, last2, out, comp); }
+};
+
+// Runs op over the chunks of both inputs split by set_path, counting the
+// output of every chunk first and then writing it at its offset.
+template <typename RandomIt1, typename RandomIt2, typename RandomIt3, typename Compare, typename SetOp>
+RandomIt3 parallel_set_operation(
+    RandomIt1 first1, RandomIt1 last1, RandomIt2 first2, RandomIt2 last2, RandomIt3 out,
+    Compare& comp, SetOp op
+)
+{
+    const auto size1 = static_cast<std::size_t>(std::distance(first1, last1));
+    const auto size2 = static_cast<std::size_t>(std::distance(first2, last2));
+    const auto size = size1 + size2;
+    if(size == 0) { return out; }
+
+    struct slot
+    {
+        merge_split lo;
+        merge_split hi;
+        std::size_t offset;
+    };
+    const auto n = chunk_count(size);
+    inline_buffer<slot, inline_slots<slot>> chunks(n);
+    for(std::size_t i = 0; i < n; ++i) { chunks.emplace_back(); }
+
+    for_each_chunk(size, n,
+        [=, &chunks, &comp](std::size_t i, std::size_t first, std::size_t last) {
+            auto& c = chunks[i];
+            c.lo = set_path(first1, size1, first2, size2, first, comp);
+            c.hi = set_path(first1, size1, first2, size2, last, comp);
+            c.offset = op(first1 + c.lo.first, first1 + c.hi.first,
+                          first2 + c.lo.second, first2 + c.hi.second,
+                          counting_output_iterator{}, comp).count();
+        });
+
+    std::size_t total = 0;
+    for(auto& c : chunks) { total += std::exchange(c.offset, total); }
+
+    for_each_chunk(size, n,
+        [=, &chunks, &comp](std::size_t i, std::size_t, std::size_t) {
+            const auto& c = chunks[i];
+            op(first1 + c.lo.first, first1 + c.hi.first,
+               first2 + c.lo.second, first2 + c.hi.second,
+               out + c.offset, comp);
+        });
+
+    return out + total;
+}
+
+//================================================================================
+//====================================Merge=======================================
+//================================================================================
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt merge_impl(
+    sequential_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    return std::merge(first1, last1, first2, last2, out, comp);
+}
+
+// Merges [first1, first1 + size1) and [first2, first2 + size2) to out, one
+// chunk of the output per call of merge_chunk(first1, last1, first2, last2,
+// out). The splits are all found before any chunk starts, as merging may
+// move elements out of the inputs (e.g. from inplace_merge's buffer).
+template <typename RandomIt1, typename RandomIt2, typename RandomIt3, typename Compare,
+          typename MergeChunk>
+void merge_chunks(
+    RandomIt1 first1, std::size_t size1, RandomIt2 first2, std::size_t size2, RandomIt3 out,
+    Compare& comp, MergeChunk merge_chunk
+)
+{
+    const auto size = size1 + size2;
+    const auto n = chunk_count(size);
+    inline_buffer<merge_split, inline_chunk_capacity + 1> splits(n + 1);
+    for(std::size_t i = 0; i <= n; ++i) {
+        splits.emplace_back(merge_path(first1, size1, first2, size2, chunk_begin(i, n, size), comp));
+    }
+
+    for_each_chunk(size, n, [=, &splits, &merge_chunk](std::size_t i, std::size_t first, std::size_t) {
+        const auto lo = splits[i];
+        const auto hi = splits[i + 1];
+        merge_chunk(first1 + lo.first, first1 + hi.first, first2 + lo.second, first2 + hi.second,
+                    out + first);
+    });
+}
+
+// std::merge, moving the elements to out. Unlike std::merge over move
+// iterators, comp is only ever given lvalues, so a comparator taking its
+// arguments by value copies them rather than moving them out.
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt move_merge(
+    InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2, OutputIt out,
+    Compare& comp
+)
+{
+    for(; first1 != last1 && first2 != last2; ++out) {
+        if(comp(*first2, *first1)) { *out = std::move(*first2); ++first2; }
+        else { *out = std::move(*first1); ++first1; }
+    }
+    out = std::move(first1, last1, out);
+    return std::move(first2, last2, out);
+}
+
+template <typename RandomIt1, typename RandomIt2, typename RandomIt3, typename Compare>
+RandomIt3 merge_impl(
+    parallel_execution_policy, RandomIt1 first1, RandomIt1 last1,
+    RandomIt2 first2, RandomIt2 last2, RandomIt3 out, Compare comp,
+    enable_if_random_merge<RandomIt1, RandomIt2, RandomIt3>* = 0
+)
+{
+    const auto size1 = static_cast<std::size_t>(std::distance(first1, last1));
+    const auto size2 = static_cast<std::size_t>(std::distance(first2, last2));
+
+    merge_chunks(first1, size1, first2, size2, out, comp,
+        [&comp](RandomIt1 f1, RandomIt1 l1, RandomIt2 f2, RandomIt2 l2, RandomIt3 o) {
+            std::merge(f1, l1, f2, l2, o, comp);
+        });
+
+    return out + (size1 + size2);
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt merge_impl(
+    parallel_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp,
+    enable_if_not_random_merge<InputIt1, InputIt2, OutputIt>* = 0
+)
+{
+    return std::merge(first1, last1, first2, last2, out, comp);
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt merge_impl(
+    parallel_vector_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    return merge_impl(par, first1, last1, first2, last2, out, comp);
+}
+
+//================================================================================
+
+template <typename BidirIt, typename Compare>
+void inplace_merge_impl(
+    sequential_execution_policy, BidirIt first, BidirIt middle, BidirIt last, Compare comp
+)
+{
+    std::inplace_merge(first, middle, last, comp);
+}
+
+// Moves the range out into a buffer and merges it back.
+template <typename RandomIt, typename Compare>
+void inplace_merge_impl(
+    parallel_execution_policy, RandomIt first, RandomIt middle, RandomIt last, Compare comp,
+    enable_if_random<RandomIt>* = 0
+)
+{
+    using value_type = iter_value_t<RandomIt>;
+
+    if(first == middle || middle == last) { return; }
+
+    const auto size = static_cast<std::size_t>(std::distance(first, last));
+    const auto size1 = static_cast<std::size_t>(std::distance(first, middle));
+
+    raw_buffer<value_type> buffer(size);
+    auto* moved = buffer.data();
+    if(!moved) {
+        std::inplace_merge(first, middle, last, comp);
+        return;
+    }
+
+    uninitialized_move_impl(par, first, last, moved);
+    buffer.constructed(size);
+
+    merge_chunks(moved, size1, moved + size1, size - size1, first, comp,
+        [&comp](value_type* f1, value_type* l1, value_type* f2, value_type* l2, RandomIt o) {
+            move_merge(f1, l1, f2, l2, o, comp);
+        });
+}
+
+template <typename BidirIt, typename Compare>
+void inplace_merge_impl(
+    parallel_execution_policy, BidirIt first, BidirIt middle, BidirIt last, Compare comp,
+    enable_if_not_random<BidirIt>* = 0
+)
+{
+    std::inplace_merge(first, middle, last, comp);
+}
+
+template <typename BidirIt, typename Compare>
+void inplace_merge_impl(
+    parallel_vector_execution_policy, BidirIt first, BidirIt middle, BidirIt last, Compare comp
+)
+{
+    inplace_merge_impl(par, first, middle, last, comp);
+}
+
+//================================================================================
+//================================Set Operations==================================
+//================================================================================
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_union_impl(
+    sequential_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    return std::set_union(first1, last1, first2, last2, out, comp);
+}
+
+template <typename RandomIt1, typename RandomIt2, typename RandomIt3, typename Compare>
+RandomIt3 set_union_impl(
+    parallel_execution_policy, RandomIt1 first1, RandomIt1 last1,
+    RandomIt2 first2, RandomIt2 last2, RandomIt3 out, Compare comp,
+    enable_if_random_merge<RandomIt1, RandomIt2, RandomIt3>* = 0
+)
+{
+    return parallel_set_operation(first1, last1, first2, last2, out, comp, set_union_op{});
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_union_impl(
+    parallel_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp,
+    enable_if_not_random_merge<InputIt1, InputIt2, OutputIt>* = 0
+)
+{
+    return std::set_union(first1, last1, first2, last2, out, comp);
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_union_impl(
+    parallel_vector_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    return set_union_impl(par, first1, last1, first2, last2, out, comp);
+}
+
+//================================================================================
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_intersection_impl(
+    sequential_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    return std::set_intersection(first1, last1, first2, last2, out, comp);
+}
+
+template <typename RandomIt1, typename RandomIt2, typename RandomIt3, typename Compare>
+RandomIt3 set_intersection_impl(
+    parallel_execution_policy, RandomIt1 first1, RandomIt1 last1,
+    RandomIt2 first2, RandomIt2 last2, RandomIt3 out, Compare comp,
+    enable_if_random_merge<RandomIt1, RandomIt2, RandomIt3>* = 0
+)
+{
+    return parallel_set_operation(first1, last1, first2, last2, out, comp, set_intersection_op{});
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_intersection_impl(
+    parallel_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp,
+    enable_if_not_random_merge<InputIt1, InputIt2, OutputIt>* = 0
+)
+{
+    return std::set_intersection(first1, last1, first2, last2, out, comp);
+}
+
+template <typename RandomIt1, typename RandomIt2, typename RandomIt3, typename Compare>
+RandomIt3 set_intersection_impl(
+    parallel_vector_execution_policy, RandomIt1 first1, RandomIt1 last1,
+    RandomIt2 first2, RandomIt2 last2, RandomIt3 out, Compare comp,
+    typename std::enable_if<
+        is_random_merge_v<RandomIt1, RandomIt2, RandomIt3> &&
+        is_integer_intersection_v<RandomIt1, RandomIt2, Compare>
+    >::type* = 0
+)
+{
+    return parallel_set_operation(first1, last1, first2, last2, out, comp,
+                                  branchless_intersection_op{});
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_intersection_impl(
+    parallel_vector_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp,
+    typename std::enable_if<
+        !(is_random_merge_v<InputIt1, InputIt2, OutputIt> &&
+          is_integer_intersection_v<InputIt1, InputIt2, Compare>)
+    >::type* = 0
+)
+{
+    return set_intersection_impl(par, first1, last1, first2, last2, out, comp);
+}
+
+//================================================================================
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_difference_impl(
+    sequential_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    return std::set_difference(first1, last1, first2, last2, out, comp);
+}
+
+template <typename RandomIt1, typename RandomIt2, typename RandomIt3, typename Compare>
+RandomIt3 set_difference_impl(
+    parallel_execution_policy, RandomIt1 first1, RandomIt1 last1,
+    RandomIt2 first2, RandomIt2 last2, RandomIt3 out, Compare comp,
+    enable_if_random_merge<RandomIt1, RandomIt2, RandomIt3>* = 0
+)
+{
+    return parallel_set_operation(first1, last1, first2, last2, out, comp, set_difference_op{});
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_difference_impl(
+    parallel_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp,
+    enable_if_not_random_merge<InputIt1, InputIt2, OutputIt>* = 0
+)
+{
+    return std::set_difference(first1, last1, first2, last2, out, comp);
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_difference_impl(
+    parallel_vector_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    return set_difference_impl(par, first1, last1, first2, last2, out, comp);
+}
+
+//================================================================================
+
+template <typename InputIt1, typename InputIt2, typename Compare>
+bool includes_impl(
+    sequential_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, Compare comp
+)
+{
+    return std::includes(first1, last1, first2, last2, comp);
+}
+
+template <typename RandomIt1, typename RandomIt2, typename Compare>
+bool includes_impl(
+    parallel_execution_policy, RandomIt1 first1, RandomIt1 last1,
+    RandomIt2 first2, RandomIt2 last2, Compare comp,
+    enable_if_random_pair<RandomIt1, RandomIt2>* = 0
+)
+{
+    const auto size1 = static_cast<std::size_t>(std::distance(first1, last1));
+    const auto size2 = static_cast<std::size_t>(std::distance(first2, last2));
+    if(size2 > size1) { return false; }
+
+    std::atomic<bool> included{true};
+    for_each_chunk(size1 + size2,
+        [=, &included, &comp](std::size_t, std::size_t first, std::size_t last) {
+            if(!included.load(std::memory_order_relaxed)) { return; }
+            const auto lo = set_path(first1, size1, first2, size2, first, comp);
+            const auto hi = set_path(first1, size1, first2, size2, last, comp);
+            if(!std::includes(first1 + lo.first, first1 + hi.first,
+                              first2 + lo.second, first2 + hi.second, comp)) {
+                included.store(false, std::memory_order_relaxed);
+            }
+        });
+
+    return included;
+}
+
+template <typename InputIt1, typename InputIt2, typename Compare>
+bool includes_impl(
+    parallel_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, Compare comp,
+    enable_if_not_random_pair<InputIt1, InputIt2>* = 0
+)
+{
+    return std::includes(first1, last1, first2, last2, comp);
+}
+
+template <typename InputIt1, typename InputIt2, typename Compare>
+bool includes_impl(
+    parallel_vector_execution_policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, Compare comp
+)
+{
+    return includes_impl(par, first1, last1, first2, last2, comp);
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename InputIt1, typename InputIt2, typename OutputIt,
+          typename Compare>
+OutputIt merge(
+    ExecutionPolicy&& policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::merge_impl(policy, first1, last1, first2, last2, out, comp);
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt merge(
+    execution_policy policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    auto f = [first1, last1, first2, last2, out, comp](auto policy)
+             { return internal::merge_impl(policy, first1, last1, first2, last2, out, comp); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename InputIt1, typename InputIt2, typename OutputIt>
+OutputIt merge(
+    ExecutionPolicy&& policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::merge_impl(policy, first1, last1, first2, last2, out, std::less<>{});
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt>
+OutputIt merge(
+    execution_policy policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out
+)
+{
+    return merge(policy, first1, last1, first2, last2, out, std::less<>{});
+}
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename BidirIt, typename Compare>
+void inplace_merge(
+    ExecutionPolicy&& policy, BidirIt first, BidirIt middle, BidirIt last, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    internal::inplace_merge_impl(policy, first, middle, last, comp);
+}
+
+template <typename BidirIt, typename Compare>
+void inplace_merge(
+    execution_policy policy, BidirIt first, BidirIt middle, BidirIt last, Compare comp
+)
+{
+    auto f = [first, middle, last, comp](auto policy)
+             { return internal::inplace_merge_impl(policy, first, middle, last, comp); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename BidirIt>
+void inplace_merge(
+    ExecutionPolicy&& policy, BidirIt first, BidirIt middle, BidirIt last,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    internal::inplace_merge_impl(policy, first, middle, last, std::less<>{});
+}
+
+template <typename BidirIt>
+void inplace_merge(
+    execution_policy policy, BidirIt first, BidirIt middle, BidirIt last
+)
+{
+    inplace_merge(policy, first, middle, last, std::less<>{});
+}
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename InputIt1, typename InputIt2, typename OutputIt,
+          typename Compare>
+OutputIt set_union(
+    ExecutionPolicy&& policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::set_union_impl(policy, first1, last1, first2, last2, out, comp);
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_union(
+    execution_policy policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    auto f = [first1, last1, first2, last2, out, comp](auto policy)
+             { return internal::set_union_impl(policy, first1, last1, first2, last2, out, comp); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename InputIt1, typename InputIt2, typename OutputIt>
+OutputIt set_union(
+    ExecutionPolicy&& policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::set_union_impl(policy, first1, last1, first2, last2, out, std::less<>{});
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt>
+OutputIt set_union(
+    execution_policy policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out
+)
+{
+    return set_union(policy, first1, last1, first2, last2, out, std::less<>{});
+}
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename InputIt1, typename InputIt2, typename OutputIt,
+          typename Compare>
+OutputIt set_intersection(
+    ExecutionPolicy&& policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::set_intersection_impl(policy, first1, last1, first2, last2, out, comp);
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_intersection(
+    execution_policy policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    auto f = [first1, last1, first2, last2, out, comp](auto policy)
+             { return internal::set_intersection_impl(policy, first1, last1, first2, last2, out, comp); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename InputIt1, typename InputIt2, typename OutputIt>
+OutputIt set_intersection(
+    ExecutionPolicy&& policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::set_intersection_impl(policy, first1, last1, first2, last2, out, std::less<>{});
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt>
+OutputIt set_intersection(
+    execution_policy policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out
+)
+{
+    return set_intersection(policy, first1, last1, first2, last2, out, std::less<>{});
+}
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename InputIt1, typename InputIt2, typename OutputIt,
+          typename Compare>
+OutputIt set_difference(
+    ExecutionPolicy&& policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::set_difference_impl(policy, first1, last1, first2, last2, out, comp);
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt set_difference(
+    execution_policy policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out, Compare comp
+)
+{
+    auto f = [first1, last1, first2, last2, out, comp](auto policy)
+             { return internal::set_difference_impl(policy, first1, last1, first2, last2, out, comp); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename InputIt1, typename InputIt2, typename OutputIt>
+OutputIt set_difference(
+    ExecutionPolicy&& policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::set_difference_impl(policy, first1, last1, first2, last2, out, std::less<>{});
+}
+
+template <typename InputIt1, typename InputIt2, typename OutputIt>
+OutputIt set_difference(
+    execution_policy policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, OutputIt out
+)
+{
+    return set_difference(policy, first1, last1, first2, last2, out, std::less<>{});
+}
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename InputIt1, typename InputIt2, typename Compare>
+bool includes(
+    ExecutionPolicy&& policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::includes_impl(policy, first1, last1, first2, last2, comp);
+}
+
+template <typename InputIt1, typename InputIt2, typename Compare>
+bool includes(
+    execution_policy policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2, Compare comp
+)
+{
+    auto f = [first1, last1, first2, last2, comp](auto policy)
+             { return internal::includes_impl(policy, first1, last1, first2, last2, comp); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename InputIt1, typename InputIt2>
+bool includes(
+    ExecutionPolicy&& policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::includes_impl(policy, first1, last1, first2, last2, std::less<>{});
+}
+
+template <typename InputIt1, typename InputIt2>
+bool includes(
+    execution_policy policy, InputIt1 first1, InputIt1 last1,
+    InputIt2 first2, InputIt2 last2
+)
+{
+    return includes(policy, first1, last1, first2, last2, std::less<>{});
+}
+
+} // end namespace parallel
+} // end namespace experimental
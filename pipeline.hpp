@@ -0,0 +1,866 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "all_any_none.hpp"
+#include "count.hpp"
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "for_each.hpp"
+#include "iterator_operators.hpp"
+#include "thread_pool.hpp"
+#include "zip_iterator.hpp"
+
+// Lazy range adaptors that can be composed with operator| and handed to the
+// algorithms directly:
+//
+//     count_if(par, data | views::transform(f) | views::filter(g), h);
+//
+// The algorithms never walk the adaptor iterators. Instead, a pipeline is
+// lowered to its root range (the random access range at the bottom of the
+// chain) plus a "visit" function that pushes every root element through each
+// stage. The existing chunked implementations then run over the root range
+// with the fused function, so the whole pipeline is a single parallel pass
+// with no temporaries.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+//===============================View Traits======================================
+//================================================================================
+
+// Anything deriving from view_base is cheap to copy and is stored by value
+// inside other views. Anything else is wrapped in a ref_view or owning_view.
+struct view_base { };
+
+// Pipeline stages (transform, filter, take_while) that have to be lowered
+// before running an algorithm.
+struct pipeline_view_base : view_base { };
+
+template <typename T>
+constexpr bool is_view_v = std::is_base_of<view_base, std::decay_t<T>>::value;
+
+template <typename T>
+constexpr bool is_pipeline_view_v =
+    std::is_base_of<pipeline_view_base, std::decay_t<T>>::value;
+
+template <typename Range, typename = void>
+struct is_range : std::false_type { };
+
+template <typename Range>
+struct is_range<Range, decltype((void)std::end(std::declval<Range&>()),
+                                (void)std::begin(std::declval<Range&>()))>
+    : std::true_type
+{ };
+
+template <typename Range>
+using enable_if_range =
+    typename std::enable_if<is_range<std::remove_reference_t<Range>>::value>::type;
+
+//================================================================================
+
+template <typename Iterator>
+class iterator_range
+    : public view_base
+{
+public:
+
+    iterator_range(Iterator b, Iterator e)
+        : b(b), e(e)
+    { }
+
+    Iterator begin() const { return b; }
+    Iterator end() const { return e; }
+
+private:
+
+    Iterator b;
+    Iterator e;
+};
+
+template <typename Iterator>
+iterator_range<Iterator> make_iterator_range(Iterator b, Iterator e)
+{
+    return iterator_range<Iterator>(b, e);
+}
+
+//================================================================================
+//=============================Pipeline Lowering==================================
+//================================================================================
+
+// The root of a plain range is the range itself.
+template <typename Policy, typename Range>
+auto pipeline_root(
+    Policy, Range& r,
+    typename std::enable_if<!is_pipeline_view_v<Range>>::type* = 0
+)
+{
+    using std::begin;
+    using std::end;
+    return make_iterator_range(begin(r), end(r));
+}
+
+template <typename Policy, typename Range>
+auto pipeline_root(
+    Policy p, Range& r,
+    typename std::enable_if<is_pipeline_view_v<Range>>::type* = 0
+)
+{
+    return r.root(p);
+}
+
+// Push a root element x through every stage of r, calling k with the result
+// unless one of the stages drops it.
+template <typename Range, typename T, typename K>
+void pipeline_visit(
+    const Range&, T&& x, K&& k,
+    typename std::enable_if<!is_pipeline_view_v<Range>>::type* = 0
+)
+{
+    k(std::forward<T>(x));
+}
+
+template <typename Range, typename T, typename K>
+void pipeline_visit(
+    const Range& r, T&& x, K&& k,
+    typename std::enable_if<is_pipeline_view_v<Range>>::type* = 0
+)
+{
+    r.visit(std::forward<T>(x), std::forward<K>(k));
+}
+
+//================================================================================
+
+// Index of the first element of [begin, end) satisfying pred, or
+// distance(begin, end) if there isn't one. The parallel version lets every
+// chunk stop as soon as it passes a match already found by a lower chunk.
+template <typename InputIt, typename Predicate>
+std::size_t find_first_index(
+    sequential_execution_policy, InputIt begin, InputIt end, Predicate pred
+)
+{
+    std::size_t index = 0;
+    for(; begin != end; ++begin, ++index) {
+        if(pred(*begin)) { break; }
+    }
+    return index;
+}
+
+template <typename InputIt, typename Predicate>
+std::size_t find_first_index(
+    parallel_execution_policy, InputIt begin, InputIt end, Predicate pred,
+    enable_if_random<InputIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+
+    std::atomic<std::size_t> found{size};
+
+    for_each_chunk(size,
+        [begin, pred, &found](std::size_t, std::size_t first, std::size_t last) {
+        for(auto j = first; j != last; ++j) {
+            if(j >= found.load(std::memory_order_relaxed)) { return; }
+            if(pred(begin[j])) {
+                auto current = found.load(std::memory_order_relaxed);
+                while(j < current && !found.compare_exchange_weak(current, j))
+                { }
+                return;
+            }
+        }
+    });
+
+    return found;
+}
+
+template <typename InputIt, typename Predicate>
+std::size_t find_first_index(
+    parallel_execution_policy, InputIt begin, InputIt end, Predicate pred,
+    enable_if_not_random<InputIt>* = 0
+)
+{
+    return find_first_index(seq, begin, end, pred);
+}
+
+template <typename InputIt, typename Predicate>
+std::size_t find_first_index(
+    parallel_vector_execution_policy, InputIt begin, InputIt end, Predicate pred
+)
+{
+    return find_first_index(par, begin, end, pred);
+}
+
+} // end namespace internal
+
+//================================================================================
+//================================Iterators=======================================
+//================================================================================
+
+template <typename Iterator, typename Func>
+class transform_iterator
+    : public internal::random_access_operators<
+          transform_iterator<Iterator, Func>,
+          typename std::iterator_traits<Iterator>::difference_type
+      >
+{
+public:
+
+    using iterator_category =
+        typename std::iterator_traits<Iterator>::iterator_category;
+    using difference_type =
+        typename std::iterator_traits<Iterator>::difference_type;
+    using reference =
+        decltype(std::declval<const Func&>()(*std::declval<Iterator>()));
+    using value_type = std::decay_t<reference>;
+    using pointer = void;
+
+    transform_iterator() = default;
+
+    transform_iterator(Iterator it, const Func* f)
+        : it(it), f(f)
+    { }
+
+    reference operator*() const { return (*f)(*it); }
+    reference operator[](difference_type n) const { return (*f)(it[n]); }
+
+    Iterator base() const { return it; }
+
+    void advance(difference_type n) { std::advance(it, n); }
+    difference_type distance_to(const transform_iterator& other) const
+    { return std::distance(it, other.it); }
+    bool equal(const transform_iterator& other) const
+    { return it == other.it; }
+
+private:
+
+    Iterator it{};
+    const Func* f = nullptr;
+};
+
+//--------------------------------------------------------------------------------
+
+template <typename Iterator, typename Predicate>
+class filter_iterator
+{
+public:
+
+    using iterator_category =
+        std::common_type_t<
+            typename std::iterator_traits<Iterator>::iterator_category,
+            std::forward_iterator_tag
+        >;
+    using difference_type =
+        typename std::iterator_traits<Iterator>::difference_type;
+    using value_type = typename std::iterator_traits<Iterator>::value_type;
+    using reference = typename std::iterator_traits<Iterator>::reference;
+    using pointer = typename std::iterator_traits<Iterator>::pointer;
+
+    filter_iterator() = default;
+
+    filter_iterator(Iterator it, Iterator last, const Predicate* pred)
+        : it(it), last(last), pred(pred)
+    { satisfy(); }
+
+    reference operator*() const { return *it; }
+
+    filter_iterator& operator++() { ++it; satisfy(); return *this; }
+    filter_iterator operator++(int) { auto t = *this; ++*this; return t; }
+
+    friend bool operator==(const filter_iterator& a, const filter_iterator& b)
+    { return a.it == b.it; }
+    friend bool operator!=(const filter_iterator& a, const filter_iterator& b)
+    { return a.it != b.it; }
+
+private:
+
+    void satisfy()
+    {
+        while(it != last && !(*pred)(*it)) { ++it; }
+    }
+
+    Iterator it{};
+    Iterator last{};
+    const Predicate* pred = nullptr;
+};
+
+//--------------------------------------------------------------------------------
+
+template <typename Iterator, typename Predicate>
+class take_while_iterator
+{
+public:
+
+    using iterator_category =
+        std::common_type_t<
+            typename std::iterator_traits<Iterator>::iterator_category,
+            std::forward_iterator_tag
+        >;
+    using difference_type =
+        typename std::iterator_traits<Iterator>::difference_type;
+    using value_type = typename std::iterator_traits<Iterator>::value_type;
+    using reference = typename std::iterator_traits<Iterator>::reference;
+    using pointer = typename std::iterator_traits<Iterator>::pointer;
+
+    take_while_iterator() = default;
+
+    take_while_iterator(Iterator it, Iterator last, const Predicate* pred)
+        : it(it), last(last), pred(pred)
+    { check(); }
+
+    reference operator*() const { return *it; }
+
+    take_while_iterator& operator++() { ++it; check(); return *this; }
+    take_while_iterator operator++(int) { auto t = *this; ++*this; return t; }
+
+    friend bool operator==(const take_while_iterator& a, const take_while_iterator& b)
+    { return a.it == b.it; }
+    friend bool operator!=(const take_while_iterator& a, const take_while_iterator& b)
+    { return a.it != b.it; }
+
+private:
+
+    // Once the predicate fails, jump straight to the end so that the
+    // iterator compares equal to end().
+    void check()
+    {
+        if(it != last && !(*pred)(*it)) { it = last; }
+    }
+
+    Iterator it{};
+    Iterator last{};
+    const Predicate* pred = nullptr;
+};
+
+//================================================================================
+//==================================Views=========================================
+//================================================================================
+
+namespace views
+{
+
+// Non-owning view of an lvalue container.
+template <typename Range>
+class ref_view
+    : public internal::view_base
+{
+public:
+
+    explicit ref_view(Range& r)
+        : r(&r)
+    { }
+
+    auto begin() const { using std::begin; return begin(*r); }
+    auto end() const { using std::end; return end(*r); }
+
+private:
+
+    Range* r;
+};
+
+// Takes ownership of an rvalue container.
+template <typename Range>
+class owning_view
+    : public internal::view_base
+{
+public:
+
+    explicit owning_view(Range&& r)
+        : r(std::move(r))
+    { }
+
+    auto begin() { using std::begin; return begin(r); }
+    auto end() { using std::end; return end(r); }
+    auto begin() const { using std::begin; return begin(r); }
+    auto end() const { using std::end; return end(r); }
+
+private:
+
+    Range r;
+};
+
+template <typename Range>
+std::decay_t<Range> all(
+    Range&& r,
+    typename std::enable_if<internal::is_view_v<Range>>::type* = 0
+)
+{
+    return std::forward<Range>(r);
+}
+
+template <typename Range>
+ref_view<Range> all(
+    Range& r,
+    typename std::enable_if<!internal::is_view_v<Range>>::type* = 0
+)
+{
+    return ref_view<Range>(r);
+}
+
+template <typename Range>
+owning_view<Range> all(
+    Range&& r,
+    typename std::enable_if<
+        !internal::is_view_v<Range> && !std::is_lvalue_reference<Range>::value
+    >::type* = 0
+)
+{
+    return owning_view<Range>(std::move(r));
+}
+
+template <typename Range>
+using all_t = decltype(all(std::declval<Range>()));
+
+//--------------------------------------------------------------------------------
+
+template <typename Base, typename Func>
+class transform_view
+    : public internal::pipeline_view_base
+{
+public:
+
+    transform_view(Base base, Func f)
+        : base(std::move(base)), f(std::move(f))
+    { }
+
+    auto begin() const
+    {
+        using std::begin;
+        return make_iterator(begin(base));
+    }
+
+    auto end() const
+    {
+        using std::end;
+        return make_iterator(end(base));
+    }
+
+    template <typename Policy>
+    auto root(Policy p) const
+    { return internal::pipeline_root(p, base); }
+
+    template <typename T, typename K>
+    void visit(T&& x, K&& k) const
+    {
+        const Func& func = f;
+        internal::pipeline_visit(base, std::forward<T>(x),
+            [&k, &func](auto&& y) { k(func(std::forward<decltype(y)>(y))); });
+    }
+
+private:
+
+    template <typename Iterator>
+    transform_iterator<Iterator, Func> make_iterator(Iterator it) const
+    { return transform_iterator<Iterator, Func>(it, &f); }
+
+    Base base;
+    Func f;
+};
+
+//--------------------------------------------------------------------------------
+
+template <typename Base, typename Predicate>
+class filter_view
+    : public internal::pipeline_view_base
+{
+public:
+
+    filter_view(Base base, Predicate pred)
+        : base(std::move(base)), pred(std::move(pred))
+    { }
+
+    auto begin() const
+    {
+        using std::begin;
+        using std::end;
+        using iterator = filter_iterator<decltype(begin(base)), Predicate>;
+        return iterator(begin(base), end(base), &pred);
+    }
+
+    auto end() const
+    {
+        using std::end;
+        using iterator = filter_iterator<decltype(end(base)), Predicate>;
+        return iterator(end(base), end(base), &pred);
+    }
+
+    template <typename Policy>
+    auto root(Policy p) const
+    { return internal::pipeline_root(p, base); }
+
+    template <typename T, typename K>
+    void visit(T&& x, K&& k) const
+    {
+        const Predicate& p = pred;
+        internal::pipeline_visit(base, std::forward<T>(x),
+            [&k, &p](auto&& y) {
+                if(p(y)) { k(std::forward<decltype(y)>(y)); }
+            });
+    }
+
+private:
+
+    Base base;
+    Predicate pred;
+};
+
+//--------------------------------------------------------------------------------
+
+template <typename Base, typename Predicate>
+class take_while_view
+    : public internal::pipeline_view_base
+{
+public:
+
+    take_while_view(Base base, Predicate pred)
+        : base(std::move(base)), pred(std::move(pred))
+    { }
+
+    auto begin() const
+    {
+        using std::begin;
+        using std::end;
+        using iterator = take_while_iterator<decltype(begin(base)), Predicate>;
+        return iterator(begin(base), end(base), &pred);
+    }
+
+    auto end() const
+    {
+        using std::end;
+        using iterator = take_while_iterator<decltype(end(base)), Predicate>;
+        return iterator(end(base), end(base), &pred);
+    }
+
+    // Lowering a take_while cuts the root range at the first root element
+    // whose (transformed, unfiltered) value fails the predicate. That search
+    // is itself done in parallel, so the result stays a random access range.
+    template <typename Policy>
+    auto root(Policy p) const
+    {
+        auto r = internal::pipeline_root(p, base);
+        const Predicate& pr = pred;
+        const Base& b = base;
+        const auto cut = internal::find_first_index(p, r.begin(), r.end(),
+            [&pr, &b](auto&& x) {
+                bool stop = false;
+                internal::pipeline_visit(b, std::forward<decltype(x)>(x),
+                    [&pr, &stop](auto&& y) { stop = !pr(y); });
+                return stop;
+            });
+        auto last = r.begin();
+        std::advance(last, cut);
+        return internal::make_iterator_range(r.begin(), last);
+    }
+
+    template <typename T, typename K>
+    void visit(T&& x, K&& k) const
+    {
+        internal::pipeline_visit(base, std::forward<T>(x), std::forward<K>(k));
+    }
+
+private:
+
+    Base base;
+    Predicate pred;
+};
+
+//--------------------------------------------------------------------------------
+
+// zip is a root range rather than a pipeline stage: it is random access
+// whenever all the zipped ranges are, and its elements are tuples of
+// references into each of them.
+template <typename... Ranges>
+class zip_view
+    : public internal::view_base
+{
+public:
+
+    explicit zip_view(Ranges... rs)
+        : ranges(std::move(rs)...)
+    { }
+
+    auto begin() const
+    { return make_begin(std::index_sequence_for<Ranges...>{}); }
+
+    // All ranges are cut to the length of the shortest one.
+    auto end() const
+    { return std::next(begin(), size(std::index_sequence_for<Ranges...>{})); }
+
+private:
+
+    template <std::size_t... I>
+    auto make_begin(std::index_sequence<I...>) const
+    {
+        using std::begin;
+        return zip_iterator<decltype(begin(std::get<I>(ranges)))...>(
+            begin(std::get<I>(ranges))...
+        );
+    }
+
+    template <std::size_t... I>
+    std::ptrdiff_t size(std::index_sequence<I...>) const
+    {
+        using std::begin;
+        using std::end;
+        return std::min({
+            static_cast<std::ptrdiff_t>(
+                std::distance(begin(std::get<I>(ranges)), end(std::get<I>(ranges)))
+            )...
+        });
+    }
+
+    std::tuple<Ranges...> ranges;
+};
+
+//================================================================================
+//===============================Adaptors=========================================
+//================================================================================
+
+template <typename Func>
+struct transform_adaptor { Func f; };
+
+template <typename Predicate>
+struct filter_adaptor { Predicate pred; };
+
+template <typename Predicate>
+struct take_while_adaptor { Predicate pred; };
+
+template <typename Func>
+transform_adaptor<Func> transform(Func f) { return { std::move(f) }; }
+
+template <typename Predicate>
+filter_adaptor<Predicate> filter(Predicate pred) { return { std::move(pred) }; }
+
+template <typename Predicate>
+take_while_adaptor<Predicate> take_while(Predicate pred) { return { std::move(pred) }; }
+
+template <typename... Ranges>
+zip_view<all_t<Ranges>...> zip(Ranges&&... rs)
+{
+    return zip_view<all_t<Ranges>...>(all(std::forward<Ranges>(rs))...);
+}
+
+template <typename Range, typename Func>
+transform_view<all_t<Range>, Func> operator|(Range&& r, transform_adaptor<Func> a)
+{
+    return { all(std::forward<Range>(r)), std::move(a.f) };
+}
+
+template <typename Range, typename Predicate>
+filter_view<all_t<Range>, Predicate> operator|(Range&& r, filter_adaptor<Predicate> a)
+{
+    return { all(std::forward<Range>(r)), std::move(a.pred) };
+}
+
+template <typename Range, typename Predicate>
+take_while_view<all_t<Range>, Predicate>
+operator|(Range&& r, take_while_adaptor<Predicate> a)
+{
+    return { all(std::forward<Range>(r)), std::move(a.pred) };
+}
+
+} // end namespace views
+
+//================================================================================
+//=============================Range Algorithms===================================
+//================================================================================
+
+namespace internal
+{
+
+template <typename Policy, typename Range, typename Func>
+void for_each_range_impl(Policy policy, Range& r, Func f)
+{
+    auto root = pipeline_root(policy, r);
+    for_each_impl(policy, root.begin(), root.end(),
+        [&r, f](auto&& x) { pipeline_visit(r, std::forward<decltype(x)>(x), f); });
+}
+
+// Elements dropped by a filter stage evaluate to `dropped`: false for
+// count_if, any_of and none_of, true for all_of.
+template <typename Range, typename Predicate>
+auto fused_predicate(const Range& r, Predicate pred, bool dropped)
+{
+    return [&r, pred, dropped](auto&& x) {
+        bool result = dropped;
+        pipeline_visit(r, std::forward<decltype(x)>(x),
+            [&result, &pred](auto&& y) { result = pred(y); });
+        return result;
+    };
+}
+
+template <typename Policy, typename Range, typename Predicate>
+auto count_if_range_impl(Policy policy, Range& r, Predicate pred)
+{
+    auto root = pipeline_root(policy, r);
+    return count_if_impl(policy, root.begin(), root.end(),
+                         fused_predicate(r, pred, false));
+}
+
+template <typename Policy, typename Range, typename Predicate>
+bool any_of_range_impl(Policy policy, Range& r, Predicate pred)
+{
+    auto root = pipeline_root(policy, r);
+    return any_of_impl(policy, root.begin(), root.end(),
+                       fused_predicate(r, pred, false));
+}
+
+template <typename Policy, typename Range, typename Predicate>
+bool all_of_range_impl(Policy policy, Range& r, Predicate pred)
+{
+    auto root = pipeline_root(policy, r);
+    return all_of_impl(policy, root.begin(), root.end(),
+                       fused_predicate(r, pred, true));
+}
+
+template <typename Policy, typename Range, typename Predicate>
+bool none_of_range_impl(Policy policy, Range& r, Predicate pred)
+{
+    auto root = pipeline_root(policy, r);
+    return none_of_impl(policy, root.begin(), root.end(),
+                        fused_predicate(r, pred, false));
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename Range, typename Func>
+void for_each(
+    ExecutionPolicy&& policy, Range&& r, Func func,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    internal::for_each_range_impl(policy, r, func);
+}
+
+template <typename Range, typename Func>
+void for_each(
+    execution_policy policy, Range&& r, Func func,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    auto f = [&r, func](auto policy)
+             { return internal::for_each_range_impl(policy, r, func); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename Range, typename UnaryPredicate>
+auto count_if(
+    ExecutionPolicy&& policy, Range&& r, UnaryPredicate p,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    return internal::count_if_range_impl(policy, r, p);
+}
+
+template <typename Range, typename UnaryPredicate>
+auto count_if(
+    execution_policy policy, Range&& r, UnaryPredicate p,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    auto func = [&r, p](auto policy)
+                { return internal::count_if_range_impl(policy, r, p); };
+    return internal::dispatch(policy, func);
+}
+
+template <typename ExecutionPolicy, typename Range, typename T>
+auto count(
+    ExecutionPolicy&& policy, Range&& r, const T& value,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    return internal::count_if_range_impl(policy, r,
+        [&value](const auto& input) { return input == value; });
+}
+
+template <typename Range, typename T>
+auto count(
+    execution_policy policy, Range&& r, const T& value,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    auto pred = [&value](const auto& input) { return input == value; };
+    auto func = [&r, pred](auto policy)
+                { return internal::count_if_range_impl(policy, r, pred); };
+    return internal::dispatch(policy, func);
+}
+
+template <typename ExecutionPolicy, typename Range, typename Predicate>
+bool any_of(
+    ExecutionPolicy&& policy, Range&& r, Predicate pred,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    return internal::any_of_range_impl(policy, r, pred);
+}
+
+template <typename ExecutionPolicy, typename Range, typename Predicate>
+bool all_of(
+    ExecutionPolicy&& policy, Range&& r, Predicate pred,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    return internal::all_of_range_impl(policy, r, pred);
+}
+
+template <typename ExecutionPolicy, typename Range, typename Predicate>
+bool none_of(
+    ExecutionPolicy&& policy, Range&& r, Predicate pred,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    return internal::none_of_range_impl(policy, r, pred);
+}
+
+template <typename Range, typename Predicate>
+bool any_of(
+    execution_policy policy, Range&& r, Predicate pred,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    auto func = [&r, pred](auto policy)
+                { return internal::any_of_range_impl(policy, r, pred); };
+    return internal::dispatch(policy, func);
+}
+
+template <typename Range, typename Predicate>
+bool all_of(
+    execution_policy policy, Range&& r, Predicate pred,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    auto func = [&r, pred](auto policy)
+                { return internal::all_of_range_impl(policy, r, pred); };
+    return internal::dispatch(policy, func);
+}
+
+template <typename Range, typename Predicate>
+bool none_of(
+    execution_policy policy, Range&& r, Predicate pred,
+    internal::enable_if_range<Range>* = 0
+)
+{
+    auto func = [&r, pred](auto policy)
+                { return internal::none_of_range_impl(policy, r, pred); };
+    return internal::dispatch(policy, func);
+}
+
+} // end namespace parallel
+} // end namespace experimental
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "thread_pool.hpp"
+
+// Parallel generation of random data that is reproducible regardless of the
+// policy, thread count or chunking:
+//
+//     using namespace experimental::parallel;
+//     std::normal_distribution<double> dist(0.0, 1.0);
+//     generate_random(par, v.begin(), v.end(), dist, 42);
+//
+// Element i is produced by a fresh copy of dist drawing from a Philox4x32-10
+// generator keyed by the seed, whose counter is set to i. Philox is counter
+// based: any position of any stream can be computed directly, so chunks need
+// no shared engine state and the output only ever depends on (seed, i).
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+struct philox_lanes;
+
+} // end namespace internal
+
+//================================================================================
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+// 3"), usable as a UniformRandomBitGenerator. The 128-bit counter holds the
+// stream number in its upper half and the block number within the stream in
+// its lower half; every block yields four 32-bit outputs.
+class philox4x32
+{
+public:
+
+    using result_type = std::uint32_t;
+    using counter_type = std::array<std::uint32_t, 4>;
+    using key_type = std::array<std::uint32_t, 2>;
+
+    static constexpr std::size_t rounds = 10;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    explicit philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0)
+        : key{{ static_cast<std::uint32_t>(seed),
+                static_cast<std::uint32_t>(seed >> 32) }},
+          counter{{ 0, 0,
+                    static_cast<std::uint32_t>(stream),
+                    static_cast<std::uint32_t>(stream >> 32) }}
+    { }
+
+    result_type operator()()
+    {
+        if(position == output.size()) { refill(); }
+        return output[position++];
+    }
+
+    void discard(unsigned long long n)
+    {
+        for(; n > 0; --n) { (*this)(); }
+    }
+
+    // The raw bijection: encrypts one counter block under the given key.
+    static counter_type block(counter_type c, key_type k)
+    {
+        for(std::size_t r = 0; r < rounds; ++r) {
+            if(r > 0) { bump(k); }
+            c = round(c, k);
+        }
+        return c;
+    }
+
+private:
+
+    friend struct internal::philox_lanes;
+
+    static constexpr std::uint32_t multiplier0 = 0xD2511F53;
+    static constexpr std::uint32_t multiplier1 = 0xCD9E8D57;
+    static constexpr std::uint32_t weyl0 = 0x9E3779B9;
+    static constexpr std::uint32_t weyl1 = 0xBB67AE85;
+
+    static void bump(key_type& k)
+    {
+        k[0] += weyl0;
+        k[1] += weyl1;
+    }
+
+    static counter_type round(const counter_type& c, const key_type& k)
+    {
+        const std::uint64_t p0 = std::uint64_t(multiplier0) * c[0];
+        const std::uint64_t p1 = std::uint64_t(multiplier1) * c[2];
+        return {{
+            static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+            static_cast<std::uint32_t>(p1),
+            static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+            static_cast<std::uint32_t>(p0)
+        }};
+    }
+
+    void refill()
+    {
+        output = block(counter, key);
+        position = 0;
+        if(++counter[0] == 0) { ++counter[1]; }
+    }
+
+    key_type key;
+    counter_type counter;
+    counter_type output{};
+    std::size_t position = 4;
+};
+
+namespace internal
+{
+
+//================================================================================
+
+// Number of streams whose first block is computed together under par_vec.
+constexpr std::size_t philox_lane_count = 8;
+
+// Computes the first block of philox_lane_count consecutive streams at once,
+// laid out lane by lane so that every round is a loop the compiler can
+// vectorize. The engines it hands out continue exactly where an engine
+// constructed with philox4x32(seed, stream) would.
+struct philox_lanes
+{
+    static constexpr std::size_t n = philox_lane_count;
+
+    philox_lanes(std::uint64_t seed, std::uint64_t first_stream)
+        : seed(seed), first_stream(first_stream)
+    {
+        philox4x32::key_type k{{ static_cast<std::uint32_t>(seed),
+                                 static_cast<std::uint32_t>(seed >> 32) }};
+        std::uint32_t c0[n], c1[n], c2[n], c3[n];
+        for(std::size_t l = 0; l < n; ++l) {
+            const auto stream = first_stream + l;
+            c0[l] = 0;
+            c1[l] = 0;
+            c2[l] = static_cast<std::uint32_t>(stream);
+            c3[l] = static_cast<std::uint32_t>(stream >> 32);
+        }
+
+        for(std::size_t r = 0; r < philox4x32::rounds; ++r) {
+            if(r > 0) { philox4x32::bump(k); }
+            for(std::size_t l = 0; l < n; ++l) {
+                const std::uint64_t p0 = std::uint64_t(philox4x32::multiplier0) * c0[l];
+                const std::uint64_t p1 = std::uint64_t(philox4x32::multiplier1) * c2[l];
+                c0[l] = static_cast<std::uint32_t>(p1 >> 32) ^ c1[l] ^ k[0];
+                c1[l] = static_cast<std::uint32_t>(p1);
+                c2[l] = static_cast<std::uint32_t>(p0 >> 32) ^ c3[l] ^ k[1];
+                c3[l] = static_cast<std::uint32_t>(p0);
+            }
+        }
+
+        for(std::size_t l = 0; l < n; ++l) {
+            first_blocks[l] = {{ c0[l], c1[l], c2[l], c3[l] }};
+        }
+    }
+
+    philox4x32 engine(std::size_t lane) const
+    {
+        philox4x32 e(seed, first_stream + lane);
+        e.output = first_blocks[lane];
+        e.position = 0;
+        e.counter[0] = 1;
+        return e;
+    }
+
+    std::uint64_t seed;
+    std::uint64_t first_stream;
+    std::array<philox4x32::counter_type, n> first_blocks;
+};
+
+//================================================================================
+
+template <typename OutputIt>
+using enable_if_random_output =
+    typename std::enable_if<
+        std::is_same<
+            typename std::iterator_traits<OutputIt>::iterator_category,
+            std::random_access_iterator_tag
+        >::value
+    >::type;
+
+template <typename OutputIt>
+using enable_if_not_random_output =
+    typename std::enable_if<
+        !std::is_same<
+            typename std::iterator_traits<OutputIt>::iterator_category,
+            std::random_access_iterator_tag
+        >::value
+    >::type;
+
+// The distribution is copied for every element, since distributions may keep
+// state between calls (e.g. std::normal_distribution generates pairs).
+template <typename OutputIt, typename Distribution>
+void generate_random_range(
+    OutputIt out, std::size_t first, std::size_t last,
+    const Distribution& dist, std::uint64_t seed
+)
+{
+    for(auto i = first; i != last; ++i, ++out) {
+        philox4x32 engine(seed, i);
+        Distribution d(dist);
+        *out = d(engine);
+    }
+}
+
+//================================================================================
+
+template <typename OutputIt, typename Distribution>
+void generate_random_impl(
+    sequential_execution_policy, OutputIt begin, OutputIt end,
+    const Distribution& dist, std::uint64_t seed
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    generate_random_range(begin, 0, size, dist, seed);
+}
+
+//================================================================================
+
+template <typename OutputIt, typename Distribution>
+void generate_random_impl(
+    parallel_execution_policy, OutputIt begin, OutputIt end,
+    const Distribution& dist, std::uint64_t seed,
+    enable_if_random_output<OutputIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+
+    for_each_chunk(size,
+        [begin, &dist, seed](std::size_t, std::size_t first, std::size_t last) {
+            auto begin_chunk = begin + first;
+            chunk_hint(begin_chunk, begin + last);
+            generate_random_range(begin_chunk, first, last, dist, seed);
+        });
+}
+
+// Every element needs its index, so iterators that can't jump ahead are just
+// filled sequentially.
+template <typename OutputIt, typename Distribution>
+void generate_random_impl(
+    parallel_execution_policy, OutputIt begin, OutputIt end,
+    const Distribution& dist, std::uint64_t seed,
+    enable_if_not_random_output<OutputIt>* = 0
+)
+{
+    generate_random_impl(seq, begin, end, dist, seed);
+}
+
+//================================================================================
+
+template <typename OutputIt, typename Distribution>
+void generate_random_impl(
+    parallel_vector_execution_policy, OutputIt begin, OutputIt end,
+    const Distribution& dist, std::uint64_t seed,
+    enable_if_random_output<OutputIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+
+    for_each_chunk(size,
+        [begin, &dist, seed](std::size_t, std::size_t first, std::size_t last) {
+            auto out = begin + first;
+            chunk_hint(out, begin + last);
+            auto i = first;
+            for(; last - i >= philox_lane_count; i += philox_lane_count) {
+                const philox_lanes lanes(seed, i);
+                for(std::size_t l = 0; l < philox_lane_count; ++l, ++out) {
+                    auto engine = lanes.engine(l);
+                    Distribution d(dist);
+                    *out = d(engine);
+                }
+            }
+            generate_random_range(out, i, last, dist, seed);
+        });
+}
+
+template <typename OutputIt, typename Distribution>
+void generate_random_impl(
+    parallel_vector_execution_policy, OutputIt begin, OutputIt end,
+    const Distribution& dist, std::uint64_t seed,
+    enable_if_not_random_output<OutputIt>* = 0
+)
+{
+    generate_random_impl(seq, begin, end, dist, seed);
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename OutputIt, typename Distribution>
+void generate_random(
+    ExecutionPolicy&& policy, OutputIt begin, OutputIt end,
+    const Distribution& dist, std::uint64_t seed,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    internal::generate_random_impl(policy, begin, end, dist, seed);
+}
+
+template <typename OutputIt, typename Distribution>
+void generate_random(
+    execution_policy policy, OutputIt begin, OutputIt end,
+    const Distribution& dist, std::uint64_t seed
+)
+{
+    auto f = [begin, end, &dist, seed](auto policy)
+             { return internal::generate_random_impl(policy, begin, end, dist, seed); };
+    return internal::dispatch(policy, f);
+}
+
+} // end namespace parallel
+} // end namespace experimental
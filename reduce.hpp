@@ -0,0 +1,383 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "count.hpp"
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "thread_pool.hpp"
+
+// Generalized sums:
+//
+//     using namespace experimental::parallel;
+//     auto total = reduce(par, v.begin(), v.end(), 0.0);
+//     auto exact = compensated_sum(par_deterministic, v.begin(), v.end(), 0.0);
+//
+// Under par the partial results of the chunks are combined in chunk order, so
+// with a non-associative op (e.g. floating point addition) the result depends
+// on how many chunks the machine uses. Under par_deterministic the range is
+// cut into blocks of deterministic_block_size elements instead, each block is
+// folded left to right, and the blocks' results are combined pairwise along a
+// fixed tree. Neither depends on the thread count, so the result is the same
+// on every machine.
+//
+// compensated_sum additionally carries a running error term (Neumaier's
+// variant of Kahan summation) through every block and every combine, which
+// keeps the error of large floating point sums close to a single rounding.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+constexpr std::size_t deterministic_block_size = 2048;
+
+template <typename InputIt, typename T, typename BinaryOp>
+T fold(InputIt begin, InputIt end, T init, BinaryOp& op)
+{
+    for(; begin != end; ++begin) { init = op(std::move(init), *begin); }
+    return init;
+}
+
+// Combines adjacent pairs level by level until one value is left, so the
+// shape of the tree only depends on the number of values. values can't be
+// empty.
+template <typename T, typename BinaryOp>
+T fold_pairwise(std::vector<T>& values, BinaryOp& op)
+{
+    auto n = values.size();
+    while(n > 1) {
+        const auto half = n / 2;
+        for(std::size_t i = 0; i < half; ++i) {
+            values[i] = op(std::move(values[2 * i]), std::move(values[2 * i + 1]));
+        }
+        if(n % 2 != 0) { values[half] = std::move(values[n - 1]); }
+        n = half + n % 2;
+    }
+    return std::move(values[0]);
+}
+
+//================================================================================
+
+template <typename InputIt, typename T, typename BinaryOp>
+T reduce_impl(
+    sequential_execution_policy, InputIt begin, InputIt end, T init, BinaryOp op
+)
+{
+    return fold(begin, end, std::move(init), op);
+}
+
+//================================================================================
+
+template <typename InputIt, typename T, typename BinaryOp>
+T reduce_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, T init, BinaryOp op,
+    enable_if_random<InputIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if(size == 0) { return init; }
+
+    // Every chunk starts from its own first element, so init is folded in
+    // exactly once.
+    struct slot { T value; };
+    inline_buffer<slot, inline_slots<slot>> partial(chunk_count(size));
+    for(std::size_t i = 0; i < chunk_count(size); ++i) { partial.emplace_back(slot{init}); }
+
+    for_each_chunk(size,
+        [begin, &partial, &op](std::size_t i, std::size_t first, std::size_t last) {
+            auto begin_chunk = begin + first;
+            auto end_chunk = begin + last;
+            chunk_hint(begin_chunk, end_chunk);
+            partial[i].value = fold(std::next(begin_chunk), end_chunk, T(*begin_chunk), op);
+        });
+
+    for(auto&& p : partial) { init = op(std::move(init), std::move(p.value)); }
+    return init;
+}
+
+template <typename InputIt, typename T, typename BinaryOp>
+T reduce_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, T init, BinaryOp op,
+    enable_if_not_random<InputIt>* = 0
+)
+{
+    return reduce_impl(seq, begin, end, std::move(init), op);
+}
+
+//================================================================================
+
+template <typename InputIt, typename T, typename BinaryOp>
+T reduce_impl(
+    parallel_deterministic_execution_policy, InputIt begin, InputIt end,
+    T init, BinaryOp op, enable_if_random<InputIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if(size == 0) { return init; }
+
+    // Blocks are independent of the chunking, so they are grouped into
+    // chunks only to spread them over the pool.
+    const auto blocks = (size + deterministic_block_size - 1) / deterministic_block_size;
+    struct slot { T value; };
+    std::vector<slot> partial;
+    partial.reserve(blocks);
+    for(std::size_t b = 0; b < blocks; ++b) { partial.push_back(slot{init}); }
+
+    for_each_chunk(blocks,
+        [begin, size, &partial, &op](std::size_t, std::size_t first, std::size_t last) {
+            for(auto b = first; b != last; ++b) {
+                auto begin_block = begin + b * deterministic_block_size;
+                auto end_block = begin + std::min(size, (b + 1) * deterministic_block_size);
+                chunk_hint(begin_block, end_block);
+                partial[b].value = fold(std::next(begin_block), end_block, T(*begin_block), op);
+            }
+        });
+
+    std::vector<T> values;
+    values.reserve(blocks);
+    for(auto&& p : partial) { values.push_back(std::move(p.value)); }
+    return op(std::move(init), fold_pairwise(values, op));
+}
+
+// Without random access the elements are visited in order anyway, which is
+// deterministic.
+template <typename InputIt, typename T, typename BinaryOp>
+T reduce_impl(
+    parallel_deterministic_execution_policy, InputIt begin, InputIt end,
+    T init, BinaryOp op, enable_if_not_random<InputIt>* = 0
+)
+{
+    return reduce_impl(seq, begin, end, std::move(init), op);
+}
+
+//================================================================================
+
+template <typename InputIt, typename T, typename BinaryOp>
+T reduce_impl(
+    parallel_vector_execution_policy, InputIt begin, InputIt end, T init, BinaryOp op
+)
+{
+    return reduce_impl(par, begin, end, std::move(init), op);
+}
+
+//================================================================================
+//=============================Compensated Sums===================================
+//================================================================================
+
+// A sum together with the rounding error it has accumulated so far.
+template <typename T>
+struct compensated
+{
+    T sum;
+    T error;
+
+    void add(const T& x)
+    {
+        const T s = sum + x;
+        // Neumaier: recover the low order bits of whichever operand was
+        // smaller in magnitude.
+        error += ((sum < 0 ? -sum : sum) >= (x < 0 ? -x : x)) ? (sum - s) + x
+                                                              : (x - s) + sum;
+        sum = s;
+    }
+
+    T value() const { return sum + error; }
+};
+
+struct compensated_plus
+{
+    template <typename T>
+    compensated<T> operator()(compensated<T> a, const compensated<T>& b) const
+    {
+        a.add(b.sum);
+        a.error += b.error;
+        return a;
+    }
+};
+
+template <typename InputIt, typename T>
+compensated<T> compensated_fold(InputIt begin, InputIt end, compensated<T> acc)
+{
+    for(; begin != end; ++begin) { acc.add(*begin); }
+    return acc;
+}
+
+//================================================================================
+
+template <typename InputIt, typename T>
+T compensated_sum_impl(
+    sequential_execution_policy, InputIt begin, InputIt end, T init
+)
+{
+    return compensated_fold(begin, end, compensated<T>{init, T()}).value();
+}
+
+template <typename InputIt, typename T>
+T compensated_sum_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, T init,
+    enable_if_random<InputIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+
+    auto total = reduce_chunks(size, compensated<T>{T(), T()},
+        [begin](std::size_t first, std::size_t last) {
+            auto begin_chunk = begin + first;
+            auto end_chunk = begin + last;
+            chunk_hint(begin_chunk, end_chunk);
+            return compensated_fold(begin_chunk, end_chunk, compensated<T>{T(), T()});
+        },
+        compensated_plus{});
+    total.add(init);
+    return total.value();
+}
+
+template <typename InputIt, typename T>
+T compensated_sum_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, T init,
+    enable_if_not_random<InputIt>* = 0
+)
+{
+    return compensated_sum_impl(seq, begin, end, init);
+}
+
+template <typename InputIt, typename T>
+T compensated_sum_impl(
+    parallel_deterministic_execution_policy, InputIt begin, InputIt end, T init,
+    enable_if_random<InputIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if(size == 0) { return init; }
+
+    const auto blocks = (size + deterministic_block_size - 1) / deterministic_block_size;
+    std::vector<compensated<T>> partial(blocks, compensated<T>{T(), T()});
+
+    for_each_chunk(blocks,
+        [begin, size, &partial](std::size_t, std::size_t first, std::size_t last) {
+            for(auto b = first; b != last; ++b) {
+                auto begin_block = begin + b * deterministic_block_size;
+                auto end_block = begin + std::min(size, (b + 1) * deterministic_block_size);
+                chunk_hint(begin_block, end_block);
+                partial[b] = compensated_fold(begin_block, end_block, compensated<T>{T(), T()});
+            }
+        });
+
+    compensated_plus op;
+    auto total = fold_pairwise(partial, op);
+    total.add(init);
+    return total.value();
+}
+
+template <typename InputIt, typename T>
+T compensated_sum_impl(
+    parallel_deterministic_execution_policy, InputIt begin, InputIt end, T init,
+    enable_if_not_random<InputIt>* = 0
+)
+{
+    return compensated_sum_impl(seq, begin, end, init);
+}
+
+template <typename InputIt, typename T>
+T compensated_sum_impl(
+    parallel_vector_execution_policy, InputIt begin, InputIt end, T init
+)
+{
+    return compensated_sum_impl(par, begin, end, init);
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename InputIt, typename T, typename BinaryOp>
+T reduce(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, T init, BinaryOp op,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::reduce_impl(policy, begin, end, std::move(init), op);
+}
+
+template <typename InputIt, typename T, typename BinaryOp>
+T reduce(
+    execution_policy policy, InputIt begin, InputIt end, T init, BinaryOp op
+)
+{
+    auto f = [begin, end, &init, op](auto policy)
+             { return internal::reduce_impl(policy, begin, end, init, op); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename InputIt, typename T>
+T reduce(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, T init,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::reduce_impl(policy, begin, end, std::move(init), std::plus<>{});
+}
+
+template <typename InputIt, typename T>
+T reduce(
+    execution_policy policy, InputIt begin, InputIt end, T init
+)
+{
+    return reduce(policy, begin, end, std::move(init), std::plus<>{});
+}
+
+template <typename ExecutionPolicy, typename InputIt>
+typename std::iterator_traits<InputIt>::value_type
+reduce(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    using value_type = typename std::iterator_traits<InputIt>::value_type;
+    return internal::reduce_impl(policy, begin, end, value_type(), std::plus<>{});
+}
+
+template <typename InputIt>
+typename std::iterator_traits<InputIt>::value_type
+reduce(
+    execution_policy policy, InputIt begin, InputIt end
+)
+{
+    using value_type = typename std::iterator_traits<InputIt>::value_type;
+    return reduce(policy, begin, end, value_type(), std::plus<>{});
+}
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename InputIt, typename T>
+T compensated_sum(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, T init,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::compensated_sum_impl(policy, begin, end, init);
+}
+
+template <typename InputIt, typename T>
+T compensated_sum(
+    execution_policy policy, InputIt begin, InputIt end, T init
+)
+{
+    auto f = [begin, end, init](auto policy)
+             { return internal::compensated_sum_impl(policy, begin, end, init); };
+    return internal::dispatch(policy, f);
+}
+
+} // end namespace parallel
+} // end namespace experimental
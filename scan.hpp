@@ -0,0 +1,325 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "count.hpp"
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "thread_pool.hpp"
+
+// Batched scans: evaluate several queries over the same range in one pass.
+//
+//     using namespace experimental::parallel;
+//     auto r = scan(par, v.begin(), v.end(),
+//                   query::count_if(p1), query::any_of(p2), query::all_of(p3));
+//     // r is a std::tuple<difference_type, bool, bool>
+//
+// Each chunk keeps a private state per query. Short-circuiting queries
+// (any_of, all_of, none_of) publish a flag once they are decided, which every
+// chunk picks up at its next block and stops evaluating that query. If all
+// the queries in a batch short-circuit, the traversal itself stops once
+// every one of them is decided.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace query
+{
+
+//================================================================================
+
+struct query_base { };
+
+template <typename Predicate>
+class count_if_query
+    : public query_base
+{
+public:
+
+    template <typename InputIt>
+    using state_type = typename std::iterator_traits<InputIt>::difference_type;
+
+    explicit count_if_query(Predicate pred)
+        : pred(std::move(pred))
+    { }
+
+    template <typename InputIt>
+    state_type<InputIt> initial() const { return 0; }
+
+    // Returns true once the query has been decided.
+    template <typename State, typename T>
+    bool step(State& s, T&& x) const
+    {
+        if(pred(x)) { ++s; }
+        return false;
+    }
+
+    template <typename State>
+    State merge(State a, State b) const { return a + b; }
+
+private:
+
+    Predicate pred;
+};
+
+//--------------------------------------------------------------------------------
+
+// any_of, all_of and none_of only differ by what decides them and what the
+// result is once decided: Decider is the predicate result that decides the
+// query, and Initial is the result if it never gets decided.
+template <typename Predicate, bool Decider, bool Initial>
+class short_circuit_query
+    : public query_base
+{
+public:
+
+    template <typename InputIt>
+    using state_type = bool;
+
+    explicit short_circuit_query(Predicate pred)
+        : pred(std::move(pred))
+    { }
+
+    template <typename InputIt>
+    bool initial() const { return Initial; }
+
+    template <typename T>
+    bool step(bool& s, T&& x) const
+    {
+        if(static_cast<bool>(pred(x)) == Decider) {
+            s = !Initial;
+            return true;
+        }
+        return false;
+    }
+
+    bool merge(bool a, bool b) const { return (a == Initial) ? b : a; }
+
+private:
+
+    Predicate pred;
+};
+
+template <typename Predicate>
+using any_of_query = short_circuit_query<Predicate, true, false>;
+
+template <typename Predicate>
+using all_of_query = short_circuit_query<Predicate, false, true>;
+
+template <typename Predicate>
+using none_of_query = short_circuit_query<Predicate, true, true>;
+
+//--------------------------------------------------------------------------------
+
+template <typename UnaryPredicate>
+count_if_query<UnaryPredicate> count_if(UnaryPredicate p)
+{
+    return count_if_query<UnaryPredicate>(std::move(p));
+}
+
+template <typename T>
+auto count(const T& value)
+{
+    return count_if([value](const auto& input) { return input == value; });
+}
+
+template <typename Predicate>
+any_of_query<Predicate> any_of(Predicate p)
+{
+    return any_of_query<Predicate>(std::move(p));
+}
+
+template <typename Predicate>
+all_of_query<Predicate> all_of(Predicate p)
+{
+    return all_of_query<Predicate>(std::move(p));
+}
+
+template <typename Predicate>
+none_of_query<Predicate> none_of(Predicate p)
+{
+    return none_of_query<Predicate>(std::move(p));
+}
+
+} // end namespace query
+
+namespace internal
+{
+
+//================================================================================
+
+// Elements evaluated between two refreshes of the shared "decided" flags.
+constexpr std::size_t scan_block_size = 4096;
+
+template <typename... Queries>
+struct is_query_pack
+    : std::integral_constant<bool, true>
+{ };
+
+template <typename Query, typename... Queries>
+struct is_query_pack<Query, Queries...>
+    : std::integral_constant<bool,
+          std::is_base_of<query::query_base, Query>::value &&
+          is_query_pack<Queries...>::value>
+{ };
+
+template <typename InputIt, typename... Queries>
+using scan_result = std::tuple<typename Queries::template state_type<InputIt>...>;
+
+template <std::size_t N>
+using decided_flags = std::array<std::atomic<bool>, N>;
+
+//================================================================================
+
+template <typename InputIt, typename... Queries, std::size_t... I>
+scan_result<InputIt, Queries...> initial_scan_states(
+    const std::tuple<Queries...>& queries, std::index_sequence<I...>
+)
+{
+    return scan_result<InputIt, Queries...>{
+        std::get<I>(queries).template initial<InputIt>()...
+    };
+}
+
+// Runs all the queries over one chunk, returning the chunk's partial states.
+template <typename InputIt, typename... Queries, std::size_t... I>
+scan_result<InputIt, Queries...> scan_chunk(
+    InputIt begin, InputIt end, const std::tuple<Queries...>& queries,
+    decided_flags<sizeof...(Queries)>& decided, std::index_sequence<I...>
+)
+{
+    using expand = int[];
+    constexpr std::size_t n = sizeof...(Queries);
+
+    auto states = initial_scan_states<InputIt>(queries, std::index_sequence<I...>{});
+    std::array<bool, n> active{};
+
+    while(begin != end) {
+        bool any_active = false;
+        for(std::size_t q = 0; q < n; ++q) {
+            active[q] = !decided[q].load(std::memory_order_relaxed);
+            any_active = any_active || active[q];
+        }
+        if(!any_active) { break; }
+
+        for(std::size_t i = 0; i < scan_block_size && begin != end; ++i, ++begin) {
+            auto&& x = *begin;
+            (void)expand{ 0, (
+                active[I] && std::get<I>(queries).step(std::get<I>(states), x)
+                    ? (active[I] = false,
+                       decided[I].store(true, std::memory_order_relaxed), 0)
+                    : 0
+            )... };
+        }
+    }
+    return states;
+}
+
+template <typename InputIt, typename... Queries, std::size_t... I>
+void merge_scan_results(
+    scan_result<InputIt, Queries...>& into,
+    const scan_result<InputIt, Queries...>& from,
+    const std::tuple<Queries...>& queries, std::index_sequence<I...>
+)
+{
+    using expand = int[];
+    (void)expand{ 0, (
+        std::get<I>(into) = std::get<I>(queries).merge(std::get<I>(into), std::get<I>(from)),
+        0
+    )... };
+}
+
+//================================================================================
+
+template <typename InputIt, typename... Queries>
+scan_result<InputIt, Queries...> scan_impl(
+    sequential_execution_policy, InputIt begin, InputIt end,
+    const std::tuple<Queries...>& queries
+)
+{
+    decided_flags<sizeof...(Queries)> decided{};
+    for(auto&& d : decided) { d.store(false); }
+    return scan_chunk(begin, end, queries, decided,
+                      std::index_sequence_for<Queries...>{});
+}
+
+template <typename InputIt, typename... Queries>
+scan_result<InputIt, Queries...> scan_impl(
+    parallel_execution_policy, InputIt begin, InputIt end,
+    const std::tuple<Queries...>& queries, enable_if_random<InputIt>* = 0
+)
+{
+    using return_type = scan_result<InputIt, Queries...>;
+    using indices = std::index_sequence_for<Queries...>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+
+    decided_flags<sizeof...(Queries)> decided{};
+    for(auto&& d : decided) { d.store(false); }
+
+    return reduce_chunks(size, initial_scan_states<InputIt>(queries, indices{}),
+        [begin, &queries, &decided](std::size_t first, std::size_t last) {
+            return scan_chunk(begin + first, begin + last, queries, decided, indices{});
+        },
+        [&queries](return_type a, const return_type& b) {
+            merge_scan_results<InputIt>(a, b, queries, indices{});
+            return a;
+        });
+}
+
+template <typename InputIt, typename... Queries>
+scan_result<InputIt, Queries...> scan_impl(
+    parallel_execution_policy, InputIt begin, InputIt end,
+    const std::tuple<Queries...>& queries, enable_if_not_random<InputIt>* = 0
+)
+{
+    return scan_impl(seq, begin, end, queries);
+}
+
+template <typename InputIt, typename... Queries>
+scan_result<InputIt, Queries...> scan_impl(
+    parallel_vector_execution_policy, InputIt begin, InputIt end,
+    const std::tuple<Queries...>& queries
+)
+{
+    return scan_impl(par, begin, end, queries);
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename InputIt, typename... Queries>
+typename std::enable_if<
+    is_execution_policy_v<std::decay_t<ExecutionPolicy>> &&
+    internal::is_query_pack<Queries...>::value,
+    internal::scan_result<InputIt, Queries...>
+>::type
+scan(ExecutionPolicy&& policy, InputIt begin, InputIt end, Queries... queries)
+{
+    const std::tuple<Queries...> qs(std::move(queries)...);
+    return internal::scan_impl(policy, begin, end, qs);
+}
+
+template <typename InputIt, typename... Queries>
+typename std::enable_if<
+    internal::is_query_pack<Queries...>::value,
+    internal::scan_result<InputIt, Queries...>
+>::type
+scan(execution_policy policy, InputIt begin, InputIt end, Queries... queries)
+{
+    const std::tuple<Queries...> qs(std::move(queries)...);
+    auto func = [begin, end, &qs](auto policy)
+                { return internal::scan_impl(policy, begin, end, qs); };
+    return internal::dispatch(policy, func);
+}
+
+} // end namespace parallel
+} // end namespace experimental
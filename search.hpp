@@ -0,0 +1,804 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#include "contiguous_iterator.hpp"
+#include "count.hpp"
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "thread_pool.hpp"
+
+// Subsequence search:
+//
+//     using namespace experimental::parallel;
+//     const std::string needle = "ERROR";
+//     auto it = search(par, log.begin(), log.end(), needle.begin(), needle.end());
+//     auto n = count_occurrences(par, log.begin(), log.end(), needle.begin(), needle.end());
+//
+// The parallel versions split the possible match positions, not the range
+// itself, into chunks: a chunk owning the positions [first, last) searches
+// the elements [first, last + m - 1) for a pattern of length m, so matches
+// straddling a chunk boundary are found exactly once, by the chunk they start
+// in. search and search_n return the lowest match and find_end the highest;
+// every chunk stops once a better match has been found by another chunk.
+//
+// Byte patterns compared with the default equality use Boyer-Moore-Horspool.
+// Under par_vec, byte patterns over contiguous memory first compare the
+// pattern's first and last bytes against a whole block of positions at once
+// (a loop the compiler vectorizes), and only check the middle of the
+// pattern at the positions where both match.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+// Match positions examined between two checks for a better match found by
+// another chunk.
+constexpr std::size_t search_block_size = 1 << 16;
+
+// Positions compared at once by the first/last byte filter.
+constexpr std::size_t search_filter_width = 32;
+
+template <typename T>
+constexpr bool is_byte_v =
+    std::is_integral<T>::value && sizeof(T) == 1 && !std::is_same<T, bool>::value;
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+constexpr bool is_byte_search_v =
+    is_byte_v<typename std::iterator_traits<ForwardIt1>::value_type> &&
+    std::is_same<
+        typename std::iterator_traits<ForwardIt1>::value_type,
+        typename std::iterator_traits<ForwardIt2>::value_type
+    >::value &&
+    std::is_same<BinaryPredicate, std::equal_to<>>::value;
+
+inline unsigned lowest_set_bit(std::uint32_t mask)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    unsigned i = 0;
+    while(!(mask & 1)) { mask >>= 1; ++i; }
+    return i;
+#endif
+}
+
+//================================================================================
+//=================================Matchers=======================================
+//================================================================================
+
+// A matcher finds the lowest match position in [first, last) of the range it
+// was built for, returning last if there is none. It may read up to
+// length() - 1 elements past last.
+
+template <typename RandomIt, typename ForwardIt, typename BinaryPredicate>
+class generic_matcher
+{
+public:
+
+    generic_matcher(RandomIt hay, ForwardIt pattern_begin, ForwardIt pattern_end,
+                    BinaryPredicate pred)
+        : hay(hay), pattern_begin(pattern_begin), pattern_end(pattern_end),
+          m(static_cast<std::size_t>(std::distance(pattern_begin, pattern_end))),
+          pred(pred)
+    { }
+
+    std::size_t length() const { return m; }
+
+    std::size_t operator()(std::size_t first, std::size_t last) const
+    {
+        const auto found = std::search(hay + first, hay + (last + m - 1),
+                                       pattern_begin, pattern_end, pred);
+        return std::min(static_cast<std::size_t>(found - hay), last);
+    }
+
+private:
+
+    RandomIt hay;
+    ForwardIt pattern_begin;
+    ForwardIt pattern_end;
+    std::size_t m;
+    BinaryPredicate pred;
+};
+
+// Boyer-Moore-Horspool: after a mismatch, shift by how far the last byte of
+// the window is from its last occurrence in the pattern.
+template <typename RandomIt>
+class horspool_matcher
+{
+public:
+
+    template <typename ForwardIt>
+    horspool_matcher(RandomIt hay, ForwardIt pattern_begin, ForwardIt pattern_end)
+        : hay(hay)
+    {
+        for(; pattern_begin != pattern_end; ++pattern_begin) {
+            pattern.push_back(static_cast<unsigned char>(*pattern_begin));
+        }
+        const auto m = pattern.size();
+        shift.fill(m);
+        for(std::size_t i = 0; i + 1 < m; ++i) { shift[pattern[i]] = m - 1 - i; }
+    }
+
+    std::size_t length() const { return pattern.size(); }
+
+    std::size_t operator()(std::size_t first, std::size_t last) const
+    {
+        const auto m = pattern.size();
+        const auto back = pattern[m - 1];
+        for(auto pos = first; pos < last; ) {
+            const auto c = static_cast<unsigned char>(hay[pos + m - 1]);
+            if(c == back && matches_at(pos)) { return pos; }
+            pos += shift[c];
+        }
+        return last;
+    }
+
+private:
+
+    bool matches_at(std::size_t pos) const
+    {
+        for(std::size_t i = 0; i + 1 < pattern.size(); ++i) {
+            if(static_cast<unsigned char>(hay[pos + i]) != pattern[i]) { return false; }
+        }
+        return true;
+    }
+
+    RandomIt hay;
+    std::vector<unsigned char> pattern;
+    std::array<std::size_t, 256> shift;
+};
+
+// Compares the first and last bytes of search_filter_width windows at a time
+// into a bit mask, without branches, and only checks the rest of the pattern
+// for the windows whose bit is set.
+template <typename ContiguousIt>
+class byte_filter_matcher
+{
+public:
+
+    template <typename ForwardIt>
+    byte_filter_matcher(ContiguousIt hay, ForwardIt pattern_begin, ForwardIt pattern_end)
+        : hay(reinterpret_cast<const unsigned char*>(to_pointer(hay)))
+    {
+        for(; pattern_begin != pattern_end; ++pattern_begin) {
+            pattern.push_back(static_cast<unsigned char>(*pattern_begin));
+        }
+    }
+
+    std::size_t length() const { return pattern.size(); }
+
+    std::size_t operator()(std::size_t first, std::size_t last) const
+    {
+        const auto m = pattern.size();
+        const unsigned char front = pattern[0];
+        const unsigned char back = pattern[m - 1];
+        const unsigned char* s = hay;
+
+        auto pos = first;
+        for(; last - pos >= search_filter_width; pos += search_filter_width) {
+            std::uint32_t mask = 0;
+            for(std::size_t j = 0; j < search_filter_width; ++j) {
+                const bool candidate = (s[pos + j] == front) & (s[pos + j + m - 1] == back);
+                mask |= std::uint32_t(candidate) << j;
+            }
+            for(; mask != 0; mask &= mask - 1) {
+                const auto at = pos + lowest_set_bit(mask);
+                if(middle_matches(at)) { return at; }
+            }
+        }
+        for(; pos < last; ++pos) {
+            if(s[pos] == front && s[pos + m - 1] == back && middle_matches(pos)) {
+                return pos;
+            }
+        }
+        return last;
+    }
+
+private:
+
+    bool middle_matches(std::size_t pos) const
+    {
+        const auto m = pattern.size();
+        return m <= 2 || std::memcmp(hay + pos + 1, pattern.data() + 1, m - 2) == 0;
+    }
+
+    const unsigned char* hay;
+    std::vector<unsigned char> pattern;
+};
+
+template <typename RandomIt, typename Size, typename T, typename BinaryPredicate>
+class repeat_matcher
+{
+public:
+
+    repeat_matcher(RandomIt hay, Size count, const T& value, BinaryPredicate pred)
+        : hay(hay), count(count), value(value), pred(pred)
+    { }
+
+    std::size_t length() const { return static_cast<std::size_t>(count); }
+
+    std::size_t operator()(std::size_t first, std::size_t last) const
+    {
+        const auto found = std::search_n(hay + first, hay + (last + length() - 1),
+                                         count, value, pred);
+        return std::min(static_cast<std::size_t>(found - hay), last);
+    }
+
+private:
+
+    RandomIt hay;
+    Size count;
+    const T& value;
+    BinaryPredicate pred;
+};
+
+//--------------------------------------------------------------------------------
+
+template <typename Policy, typename RandomIt, typename ForwardIt, typename BinaryPredicate>
+generic_matcher<RandomIt, ForwardIt, BinaryPredicate> make_matcher(
+    Policy, RandomIt hay, ForwardIt pattern_begin, ForwardIt pattern_end,
+    BinaryPredicate pred,
+    typename std::enable_if<!is_byte_search_v<RandomIt, ForwardIt, BinaryPredicate>>::type* = 0
+)
+{
+    return { hay, pattern_begin, pattern_end, pred };
+}
+
+template <typename RandomIt, typename ForwardIt, typename BinaryPredicate>
+horspool_matcher<RandomIt> make_matcher(
+    parallel_execution_policy, RandomIt hay, ForwardIt pattern_begin, ForwardIt pattern_end,
+    BinaryPredicate,
+    typename std::enable_if<is_byte_search_v<RandomIt, ForwardIt, BinaryPredicate>>::type* = 0
+)
+{
+    return { hay, pattern_begin, pattern_end };
+}
+
+template <typename RandomIt, typename ForwardIt, typename BinaryPredicate>
+horspool_matcher<RandomIt> make_matcher(
+    parallel_vector_execution_policy, RandomIt hay, ForwardIt pattern_begin,
+    ForwardIt pattern_end, BinaryPredicate,
+    typename std::enable_if<
+        is_byte_search_v<RandomIt, ForwardIt, BinaryPredicate> &&
+        !is_contiguous_iterator_v<RandomIt>
+    >::type* = 0
+)
+{
+    return { hay, pattern_begin, pattern_end };
+}
+
+template <typename RandomIt, typename ForwardIt, typename BinaryPredicate>
+byte_filter_matcher<RandomIt> make_matcher(
+    parallel_vector_execution_policy, RandomIt hay, ForwardIt pattern_begin,
+    ForwardIt pattern_end, BinaryPredicate,
+    typename std::enable_if<
+        is_byte_search_v<RandomIt, ForwardIt, BinaryPredicate> &&
+        is_contiguous_iterator_v<RandomIt>
+    >::type* = 0
+)
+{
+    return { hay, pattern_begin, pattern_end };
+}
+
+//================================================================================
+//===============================Chunk Drivers====================================
+//================================================================================
+
+// These run a matcher over the match positions [0, positions).
+
+// Lowest match position, or positions if there is none.
+template <typename Matcher>
+std::size_t first_match(const Matcher& match, std::size_t positions)
+{
+    std::atomic<std::size_t> found{positions};
+
+    for_each_chunk(positions,
+        [&match, &found](std::size_t, std::size_t first, std::size_t last) {
+            for(auto block = first; block < last; block += search_block_size) {
+                if(block >= found.load(std::memory_order_relaxed)) { return; }
+                const auto block_end = std::min(last, block + search_block_size);
+                const auto at = match(block, block_end);
+                if(at != block_end) {
+                    auto current = found.load(std::memory_order_relaxed);
+                    while(at < current && !found.compare_exchange_weak(current, at))
+                    { }
+                    return;
+                }
+            }
+        });
+
+    return found;
+}
+
+// Highest match position, or positions if there is none. Every chunk goes
+// through its blocks from the top.
+template <typename Matcher>
+std::size_t last_match(const Matcher& match, std::size_t positions)
+{
+    // Offset by one so that zero means "none found".
+    std::atomic<std::size_t> found{0};
+
+    for_each_chunk(positions,
+        [&match, &found](std::size_t, std::size_t first, std::size_t last) {
+            const auto blocks = (last - first + search_block_size - 1) / search_block_size;
+            for(auto b = blocks; b > 0; --b) {
+                const auto block = first + (b - 1) * search_block_size;
+                const auto block_end = std::min(last, block + search_block_size);
+                if(block_end <= found.load(std::memory_order_relaxed)) { return; }
+
+                auto at = match(block, block_end);
+                if(at == block_end) { continue; }
+                for(auto next = at; next != block_end; next = match(next + 1, block_end)) {
+                    at = next;
+                }
+                auto current = found.load(std::memory_order_relaxed);
+                while(at + 1 > current && !found.compare_exchange_weak(current, at + 1))
+                { }
+                return;
+            }
+        });
+
+    const auto f = found.load();
+    return (f == 0) ? positions : f - 1;
+}
+
+template <typename Matcher>
+std::size_t count_matches_in(const Matcher& match, std::size_t first, std::size_t last)
+{
+    std::size_t count = 0;
+    for(auto at = match(first, last); at != last; at = match(at + 1, last)) { ++count; }
+    return count;
+}
+
+template <typename Matcher>
+std::size_t count_matches(const Matcher& match, std::size_t positions)
+{
+    if(positions == 0) { return 0; }
+    return reduce_chunks(positions, std::size_t(0),
+        [&match](std::size_t first, std::size_t last)
+        { return count_matches_in(match, first, last); },
+        std::plus<>{});
+}
+
+// Number of possible match positions for a pattern of length m.
+template <typename RandomIt>
+std::size_t match_positions(RandomIt begin, RandomIt end, std::size_t m)
+{
+    const auto n = static_cast<std::size_t>(std::distance(begin, end));
+    return (m == 0 || n < m) ? 0 : n - m + 1;
+}
+
+//================================================================================
+//==================================search========================================
+//================================================================================
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 search_impl(
+    sequential_execution_policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred
+)
+{
+    return std::search(begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename Policy, typename RandomIt, typename ForwardIt, typename BinaryPredicate>
+RandomIt search_random_access(
+    Policy policy, RandomIt begin, RandomIt end,
+    ForwardIt pattern_begin, ForwardIt pattern_end, BinaryPredicate pred
+)
+{
+    if(pattern_begin == pattern_end) { return begin; }
+    const auto match = make_matcher(policy, begin, pattern_begin, pattern_end, pred);
+    const auto positions = match_positions(begin, end, match.length());
+    if(positions == 0) { return end; }
+
+    const auto at = first_match(match, positions);
+    return (at == positions) ? end : begin + at;
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 search_impl(
+    parallel_execution_policy pep, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    enable_if_random<ForwardIt1>* = 0
+)
+{
+    return search_random_access(pep, begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 search_impl(
+    parallel_execution_policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    enable_if_not_random<ForwardIt1>* = 0
+)
+{
+    return search_impl(seq, begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 search_impl(
+    parallel_vector_execution_policy pvep, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    enable_if_random<ForwardIt1>* = 0
+)
+{
+    return search_random_access(pvep, begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 search_impl(
+    parallel_vector_execution_policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    enable_if_not_random<ForwardIt1>* = 0
+)
+{
+    return search_impl(seq, begin, end, pattern_begin, pattern_end, pred);
+}
+
+//================================================================================
+//=================================find_end=======================================
+//================================================================================
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 find_end_impl(
+    sequential_execution_policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred
+)
+{
+    return std::find_end(begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 find_end_impl(
+    parallel_execution_policy pep, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    enable_if_random<ForwardIt1>* = 0
+)
+{
+    if(pattern_begin == pattern_end) { return end; }
+    const auto match = make_matcher(pep, begin, pattern_begin, pattern_end, pred);
+    const auto positions = match_positions(begin, end, match.length());
+    if(positions == 0) { return end; }
+
+    const auto at = last_match(match, positions);
+    return (at == positions) ? end : begin + at;
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 find_end_impl(
+    parallel_execution_policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    enable_if_not_random<ForwardIt1>* = 0
+)
+{
+    return find_end_impl(seq, begin, end, pattern_begin, pattern_end, pred);
+}
+
+// The first/last byte filter is built for finding the lowest match, so
+// find_end sticks with the par matchers.
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 find_end_impl(
+    parallel_vector_execution_policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred
+)
+{
+    return find_end_impl(par, begin, end, pattern_begin, pattern_end, pred);
+}
+
+//================================================================================
+//=============================count_occurrences==================================
+//================================================================================
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+std::size_t count_occurrences_impl(
+    sequential_execution_policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred
+)
+{
+    std::size_t count = 0;
+    if(pattern_begin == pattern_end) { return count; }
+    for(;; ++begin, ++count) {
+        begin = std::search(begin, end, pattern_begin, pattern_end, pred);
+        if(begin == end) { return count; }
+    }
+}
+
+template <typename Policy, typename RandomIt, typename ForwardIt, typename BinaryPredicate>
+std::size_t count_occurrences_random_access(
+    Policy policy, RandomIt begin, RandomIt end,
+    ForwardIt pattern_begin, ForwardIt pattern_end, BinaryPredicate pred
+)
+{
+    if(pattern_begin == pattern_end) { return 0; }
+    const auto match = make_matcher(policy, begin, pattern_begin, pattern_end, pred);
+    return count_matches(match, match_positions(begin, end, match.length()));
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+std::size_t count_occurrences_impl(
+    parallel_execution_policy pep, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    enable_if_random<ForwardIt1>* = 0
+)
+{
+    return count_occurrences_random_access(pep, begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+std::size_t count_occurrences_impl(
+    parallel_execution_policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    enable_if_not_random<ForwardIt1>* = 0
+)
+{
+    return count_occurrences_impl(seq, begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+std::size_t count_occurrences_impl(
+    parallel_vector_execution_policy pvep, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    enable_if_random<ForwardIt1>* = 0
+)
+{
+    return count_occurrences_random_access(pvep, begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+std::size_t count_occurrences_impl(
+    parallel_vector_execution_policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    enable_if_not_random<ForwardIt1>* = 0
+)
+{
+    return count_occurrences_impl(seq, begin, end, pattern_begin, pattern_end, pred);
+}
+
+//================================================================================
+//=================================search_n=======================================
+//================================================================================
+
+template <typename ForwardIt, typename Size, typename T, typename BinaryPredicate>
+ForwardIt search_n_impl(
+    sequential_execution_policy, ForwardIt begin, ForwardIt end,
+    Size count, const T& value, BinaryPredicate pred
+)
+{
+    return std::search_n(begin, end, count, value, pred);
+}
+
+template <typename ForwardIt, typename Size, typename T, typename BinaryPredicate>
+ForwardIt search_n_impl(
+    parallel_execution_policy, ForwardIt begin, ForwardIt end,
+    Size count, const T& value, BinaryPredicate pred,
+    enable_if_random<ForwardIt>* = 0
+)
+{
+    if(count <= 0) { return begin; }
+    const repeat_matcher<ForwardIt, Size, T, BinaryPredicate> match(begin, count, value, pred);
+    const auto positions = match_positions(begin, end, match.length());
+    if(positions == 0) { return end; }
+
+    const auto at = first_match(match, positions);
+    return (at == positions) ? end : begin + at;
+}
+
+template <typename ForwardIt, typename Size, typename T, typename BinaryPredicate>
+ForwardIt search_n_impl(
+    parallel_execution_policy, ForwardIt begin, ForwardIt end,
+    Size count, const T& value, BinaryPredicate pred,
+    enable_if_not_random<ForwardIt>* = 0
+)
+{
+    return search_n_impl(seq, begin, end, count, value, pred);
+}
+
+template <typename ForwardIt, typename Size, typename T, typename BinaryPredicate>
+ForwardIt search_n_impl(
+    parallel_vector_execution_policy, ForwardIt begin, ForwardIt end,
+    Size count, const T& value, BinaryPredicate pred
+)
+{
+    return search_n_impl(par, begin, end, count, value, pred);
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename ForwardIt1, typename ForwardIt2,
+          typename BinaryPredicate>
+ForwardIt1 search(
+    ExecutionPolicy&& policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::search_impl(policy, begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 search(
+    execution_policy policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred
+)
+{
+    auto f = [=](auto policy)
+             { return internal::search_impl(policy, begin, end, pattern_begin, pattern_end, pred); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt1, typename ForwardIt2>
+ForwardIt1 search(
+    ExecutionPolicy&& policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::search_impl(policy, begin, end, pattern_begin, pattern_end,
+                                 std::equal_to<>{});
+}
+
+template <typename ForwardIt1, typename ForwardIt2>
+ForwardIt1 search(
+    execution_policy policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end
+)
+{
+    return search(policy, begin, end, pattern_begin, pattern_end, std::equal_to<>{});
+}
+
+//--------------------------------------------------------------------------------
+
+template <typename ExecutionPolicy, typename ForwardIt1, typename ForwardIt2,
+          typename BinaryPredicate>
+ForwardIt1 find_end(
+    ExecutionPolicy&& policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::find_end_impl(policy, begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+ForwardIt1 find_end(
+    execution_policy policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred
+)
+{
+    auto f = [=](auto policy)
+             { return internal::find_end_impl(policy, begin, end, pattern_begin, pattern_end, pred); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt1, typename ForwardIt2>
+ForwardIt1 find_end(
+    ExecutionPolicy&& policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::find_end_impl(policy, begin, end, pattern_begin, pattern_end,
+                                   std::equal_to<>{});
+}
+
+template <typename ForwardIt1, typename ForwardIt2>
+ForwardIt1 find_end(
+    execution_policy policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end
+)
+{
+    return find_end(policy, begin, end, pattern_begin, pattern_end, std::equal_to<>{});
+}
+
+//--------------------------------------------------------------------------------
+
+// Number of positions at which the pattern occurs, overlapping occurrences
+// included. An empty pattern never occurs.
+template <typename ExecutionPolicy, typename ForwardIt1, typename ForwardIt2,
+          typename BinaryPredicate>
+std::size_t count_occurrences(
+    ExecutionPolicy&& policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::count_occurrences_impl(policy, begin, end, pattern_begin, pattern_end, pred);
+}
+
+template <typename ForwardIt1, typename ForwardIt2, typename BinaryPredicate>
+std::size_t count_occurrences(
+    execution_policy policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end, BinaryPredicate pred
+)
+{
+    auto f = [=](auto policy) {
+        return internal::count_occurrences_impl(policy, begin, end,
+                                                pattern_begin, pattern_end, pred);
+    };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt1, typename ForwardIt2>
+std::size_t count_occurrences(
+    ExecutionPolicy&& policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::count_occurrences_impl(policy, begin, end, pattern_begin, pattern_end,
+                                            std::equal_to<>{});
+}
+
+template <typename ForwardIt1, typename ForwardIt2>
+std::size_t count_occurrences(
+    execution_policy policy, ForwardIt1 begin, ForwardIt1 end,
+    ForwardIt2 pattern_begin, ForwardIt2 pattern_end
+)
+{
+    return count_occurrences(policy, begin, end, pattern_begin, pattern_end,
+                             std::equal_to<>{});
+}
+
+//--------------------------------------------------------------------------------
+
+template <typename ExecutionPolicy, typename ForwardIt, typename Size, typename T,
+          typename BinaryPredicate>
+ForwardIt search_n(
+    ExecutionPolicy&& policy, ForwardIt begin, ForwardIt end,
+    Size count, const T& value, BinaryPredicate pred,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::search_n_impl(policy, begin, end, count, value, pred);
+}
+
+template <typename ForwardIt, typename Size, typename T, typename BinaryPredicate>
+ForwardIt search_n(
+    execution_policy policy, ForwardIt begin, ForwardIt end,
+    Size count, const T& value, BinaryPredicate pred
+)
+{
+    auto f = [begin, end, count, &value, pred](auto policy)
+             { return internal::search_n_impl(policy, begin, end, count, value, pred); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt, typename Size, typename T>
+ForwardIt search_n(
+    ExecutionPolicy&& policy, ForwardIt begin, ForwardIt end,
+    Size count, const T& value,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::search_n_impl(policy, begin, end, count, value, std::equal_to<>{});
+}
+
+template <typename ForwardIt, typename Size, typename T>
+ForwardIt search_n(
+    execution_policy policy, ForwardIt begin, ForwardIt end,
+    Size count, const T& value
+)
+{
+    return search_n(policy, begin, end, count, value, std::equal_to<>{});
+}
+
+} // end namespace parallel
+} // end namespace experimental
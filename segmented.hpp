@@ -0,0 +1,321 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+// Segmented iterators (Austern, "Segmented Iterators and Hierarchical
+// Algorithms"): iterators over data stored as a sequence of segments, each
+// of which is a plain range of its own. std::deque is one (a map of
+// fixed-size blocks), and so is flatten(v) over a std::vector<std::vector<T>>:
+//
+//     using namespace experimental::parallel;
+//     std::vector<std::vector<int>> rows = ...;
+//     auto all = flatten(rows);
+//     auto n = count(par, all.begin(), all.end(), 0);
+//
+// segmented_iterator_traits describes how to take such an iterator apart
+// into the segment it is in and the local iterator within that segment. The
+// parallel for_each and count recognize segmented iterators: the chunks are
+// laid over the segments by element count, and every chunk runs its inner
+// loops over local iterators (plain pointers for std::deque) instead of doing
+// segment arithmetic on every step. Random access ones (std::deque) find the
+// chunk bounds by iterator arithmetic; others (flatten) are broken into
+// their segments up front, which allocates.
+
+namespace experimental
+{
+namespace parallel
+{
+
+//================================================================================
+
+// Specializations provide:
+//   segment_iterator, local_iterator (random access)
+//   segment(it), local(it)            where it is
+//   begin(seg), end(seg)              bounds of a segment
+//   in_segment(it)                    false only for an end iterator that is
+//                                     past the last segment
+template <typename Iterator>
+struct segmented_iterator_traits
+{
+    static constexpr bool is_segmented = false;
+};
+
+#if defined(__GLIBCXX__)
+// std::deque, through the libstdc++ iterator's members.
+template <typename T, typename Ref, typename Ptr>
+struct segmented_iterator_traits<std::_Deque_iterator<T, Ref, Ptr>>
+{
+    using iterator = std::_Deque_iterator<T, Ref, Ptr>;
+
+    static constexpr bool is_segmented = true;
+
+    using segment_iterator = typename iterator::_Map_pointer;
+    using local_iterator = Ptr;
+
+    static segment_iterator segment(const iterator& it) { return it._M_node; }
+    static local_iterator local(const iterator& it) { return it._M_cur; }
+
+    static local_iterator begin(segment_iterator seg) { return *seg; }
+    static local_iterator end(segment_iterator seg)
+    { return *seg + iterator::_S_buffer_size(); }
+
+    static bool in_segment(const iterator&) { return true; }
+};
+#endif
+
+template <typename Iterator>
+constexpr bool is_segmented_iterator_v =
+    segmented_iterator_traits<Iterator>::is_segmented;
+
+//================================================================================
+
+// Iterates over the elements of every inner range of a range of ranges, in
+// order, skipping empty inner ranges.
+template <typename OuterIt>
+class flat_iterator
+{
+public:
+
+    using inner_iterator = decltype(std::begin(*std::declval<OuterIt>()));
+
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename std::iterator_traits<inner_iterator>::value_type;
+    using difference_type = typename std::iterator_traits<inner_iterator>::difference_type;
+    using reference = typename std::iterator_traits<inner_iterator>::reference;
+    using pointer = typename std::iterator_traits<inner_iterator>::pointer;
+
+    flat_iterator() = default;
+
+    flat_iterator(OuterIt outer, OuterIt outer_last)
+        : outer(outer), outer_last(outer_last)
+    {
+        skip_empty();
+    }
+
+    reference operator*() const { return *inner; }
+
+    flat_iterator& operator++()
+    {
+        if(++inner == std::end(*outer)) {
+            ++outer;
+            skip_empty();
+        }
+        return *this;
+    }
+
+    flat_iterator operator++(int) { auto t = *this; ++*this; return t; }
+
+    friend bool operator==(const flat_iterator& a, const flat_iterator& b)
+    { return a.outer == b.outer && (a.outer == a.outer_last || a.inner == b.inner); }
+    friend bool operator!=(const flat_iterator& a, const flat_iterator& b)
+    { return !(a == b); }
+
+private:
+
+    friend struct segmented_iterator_traits<flat_iterator>;
+
+    void skip_empty()
+    {
+        while(outer != outer_last && std::begin(*outer) == std::end(*outer)) { ++outer; }
+        if(outer != outer_last) { inner = std::begin(*outer); }
+    }
+
+    OuterIt outer{};
+    OuterIt outer_last{};
+    inner_iterator inner{};
+};
+
+template <typename OuterIt>
+struct segmented_iterator_traits<flat_iterator<OuterIt>>
+{
+    using iterator = flat_iterator<OuterIt>;
+
+    static constexpr bool is_segmented =
+        std::is_same<
+            typename std::iterator_traits<typename iterator::inner_iterator>::iterator_category,
+            std::random_access_iterator_tag
+        >::value;
+
+    using segment_iterator = OuterIt;
+    using local_iterator = typename iterator::inner_iterator;
+
+    static segment_iterator segment(const iterator& it) { return it.outer; }
+    static local_iterator local(const iterator& it) { return it.inner; }
+
+    static local_iterator begin(segment_iterator seg) { return std::begin(*seg); }
+    static local_iterator end(segment_iterator seg) { return std::end(*seg); }
+
+    static bool in_segment(const iterator& it) { return it.outer != it.outer_last; }
+};
+
+template <typename OuterIt>
+class flat_range
+{
+public:
+
+    flat_range(OuterIt first, OuterIt last)
+        : first(first), last(last)
+    { }
+
+    flat_iterator<OuterIt> begin() const { return { first, last }; }
+    flat_iterator<OuterIt> end() const { return { last, last }; }
+
+private:
+
+    OuterIt first;
+    OuterIt last;
+};
+
+// A flat view over a range of ranges, e.g. std::vector<std::vector<T>>. The
+// outer range must outlive the view.
+template <typename Range>
+auto flatten(Range& r)
+{
+    using std::begin;
+    using std::end;
+    return flat_range<decltype(begin(r))>(begin(r), end(r));
+}
+
+namespace internal
+{
+
+//================================================================================
+
+template <typename Iterator>
+using enable_if_segmented =
+    typename std::enable_if<is_segmented_iterator_v<Iterator>>::type;
+
+template <typename Iterator>
+using enable_if_not_segmented =
+    typename std::enable_if<!is_segmented_iterator_v<Iterator>>::type;
+
+// Calls f(local_first, local_last) for every part of [first, last) that
+// lies in a single segment, in order.
+template <typename SegmentedIt, typename Func>
+void for_each_segment(SegmentedIt first, SegmentedIt last, Func f)
+{
+    using traits = segmented_iterator_traits<SegmentedIt>;
+
+    auto seg = traits::segment(first);
+    const auto last_seg = traits::segment(last);
+    if(seg == last_seg) {
+        if(traits::in_segment(first)) { f(traits::local(first), traits::local(last)); }
+        return;
+    }
+
+    f(traits::local(first), traits::end(seg));
+    for(++seg; seg != last_seg; ++seg) { f(traits::begin(seg), traits::end(seg)); }
+    if(traits::in_segment(last)) { f(traits::begin(seg), traits::local(last)); }
+}
+
+// The non-empty parts of a segmented range, with the offset of every part
+// from the start of the range.
+template <typename SegmentedIt>
+class segment_pieces
+{
+public:
+
+    using local_iterator = typename segmented_iterator_traits<SegmentedIt>::local_iterator;
+
+    segment_pieces(SegmentedIt first, SegmentedIt last)
+        : offsets(1, 0)
+    {
+        for_each_segment(first, last,
+            [this](local_iterator local_first, local_iterator local_last) {
+                if(local_first == local_last) { return; }
+                pieces.emplace_back(local_first, local_last);
+                offsets.push_back(offsets.back() +
+                    static_cast<std::size_t>(std::distance(local_first, local_last)));
+            });
+    }
+
+    std::size_t size() const { return offsets.back(); }
+
+    // Splits the elements into chunk_count(size()) chunks of (nearly) equal
+    // size, regardless of how they are spread over the segments, and calls
+    // f(i, local_first, local_last) on the pool for every part of chunk i
+    // that lies in a single segment.
+    template <typename Func>
+    void for_each_chunk(Func f) const
+    {
+        internal::for_each_chunk(size(),
+            [this, &f](std::size_t i, std::size_t begin, std::size_t end) {
+                if(begin == end) { return; }
+                auto p = static_cast<std::size_t>(
+                    std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin() - 1);
+                while(begin != end) {
+                    const auto part_end = std::min(end, offsets[p + 1]);
+                    auto local_first = pieces[p].first;
+                    std::advance(local_first, begin - offsets[p]);
+                    auto local_last = local_first;
+                    std::advance(local_last, part_end - begin);
+                    chunk_hint(local_first, local_last);
+                    f(i, local_first, local_last);
+                    begin = part_end;
+                    ++p;
+                }
+            });
+    }
+
+private:
+
+    std::vector<std::pair<local_iterator, local_iterator>> pieces;
+    std::vector<std::size_t> offsets;
+};
+
+// The same for a random access segmented range (std::deque): the chunk
+// bounds are found by iterator arithmetic, so nothing is allocated up front.
+template <typename SegmentedIt>
+class segment_bounds
+{
+public:
+
+    segment_bounds(SegmentedIt first, SegmentedIt last)
+        : first(first), count(static_cast<std::size_t>(std::distance(first, last)))
+    { }
+
+    std::size_t size() const { return count; }
+
+    template <typename Func>
+    void for_each_chunk(Func f) const
+    {
+        internal::for_each_chunk(count,
+            [this, &f](std::size_t i, std::size_t begin, std::size_t end) {
+                for_each_segment(first + begin, first + end,
+                    [i, &f](auto local_first, auto local_last) {
+                        if(local_first == local_last) { return; }
+                        chunk_hint(local_first, local_last);
+                        f(i, local_first, local_last);
+                    });
+            });
+    }
+
+private:
+
+    SegmentedIt first;
+    std::size_t count;
+};
+
+// The chunking of a segmented range for the parallel algorithms.
+template <typename SegmentedIt>
+using segment_chunks =
+    typename std::conditional<
+        std::is_base_of<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<SegmentedIt>::iterator_category
+        >::value,
+        segment_bounds<SegmentedIt>,
+        segment_pieces<SegmentedIt>
+    >::type;
+
+} // end namespace internal
+} // end namespace parallel
+} // end namespace experimental
@@ -0,0 +1,572 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "count.hpp"
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "thread_pool.hpp"
+
+// Selection without sorting everything:
+//
+//     using namespace experimental::parallel;
+//     nth_element(par, v.begin(), v.begin() + v.size() / 2, v.end());
+//     partial_sort(par, v.begin(), v.begin() + 1000, v.end());
+//     auto best = top_k(par, v.begin(), v.end(), 100);
+//
+// nth_element narrows the range around nth with parallel partitioning passes:
+// a pivot is picked as the median of a sample spread over the range, every
+// chunk classifies its elements as less than, equal to or greater than it,
+// and the chunks then move their elements into their slots of a scratch
+// buffer at offsets found by prefix sums over the per-chunk counts. Once the
+// remaining range is small it is finished with std::nth_element.
+// partial_sort then sorts the selected elements with one sample sort pass
+// through a scratch buffer in the same way. The scratch buffers need a
+// default constructible value type.
+//
+// top_k keeps a bounded heap of the k best elements per chunk and merges the
+// heaps at the end.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+// Ranges at most this long are handed to the sequential algorithms.
+constexpr std::size_t selection_sequential_cutoff = 1 << 15;
+
+constexpr std::size_t selection_sample_size = 63;
+
+// Sample elements per bucket when picking sample sort splitters.
+constexpr std::size_t splitter_oversampling = 16;
+
+// partial_sort goes through per-chunk heaps while every chunk is at least
+// this many times longer than the sorted prefix.
+constexpr std::size_t partial_sort_heap_ratio = 16;
+
+enum selection_class : unsigned char { class_less, class_equal, class_greater };
+
+// Partitions [begin, begin + size) into elements less than, equal to and
+// greater than pivot, in that order, going through the scratch buffer.
+// Returns the number of elements in the first two groups.
+template <typename RandomIt, typename T, typename Compare>
+std::pair<std::size_t, std::size_t> partition_three_way(
+    RandomIt begin, std::size_t size, const T& pivot, Compare& comp,
+    std::vector<T>& buffer, std::vector<unsigned char>& classes
+)
+{
+    const auto n = chunk_count(size);
+    std::vector<std::array<std::size_t, 3>> counts(n);
+
+    for_each_chunk(size,
+        [begin, &pivot, &comp, &classes, &counts](std::size_t i, std::size_t first, std::size_t last) {
+            std::array<std::size_t, 3> c{};
+            for(auto j = first; j != last; ++j) {
+                const auto& x = begin[j];
+                const auto k = comp(x, pivot) ? class_less
+                             : comp(pivot, x) ? class_greater
+                             : class_equal;
+                classes[j] = k;
+                ++c[k];
+            }
+            counts[i] = c;
+        });
+
+    // Turn the counts into every chunk's starting offset for each class.
+    std::array<std::size_t, 3> totals{};
+    for(auto&& c : counts) {
+        for(std::size_t k = 0; k < 3; ++k) {
+            const auto count = c[k];
+            c[k] = totals[k];
+            totals[k] += count;
+        }
+    }
+    const std::array<std::size_t, 3> base{{ 0, totals[0], totals[0] + totals[1] }};
+
+    for_each_chunk(size,
+        [begin, &buffer, &classes, &counts, &base](std::size_t i, std::size_t first, std::size_t last) {
+            auto offsets = counts[i];
+            for(auto j = first; j != last; ++j) {
+                const auto k = classes[j];
+                buffer[base[k] + offsets[k]++] = std::move(begin[j]);
+            }
+        });
+
+    for_each_chunk(size,
+        [begin, &buffer](std::size_t, std::size_t first, std::size_t last) {
+            std::move(buffer.begin() + first, buffer.begin() + last, begin + first);
+        });
+
+    return { totals[0], totals[1] };
+}
+
+template <typename RandomIt, typename Compare>
+typename std::iterator_traits<RandomIt>::value_type
+sample_pivot(RandomIt begin, std::size_t size, Compare& comp)
+{
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+
+    std::vector<value_type> sample;
+    sample.reserve(selection_sample_size);
+    for(std::size_t i = 0; i < selection_sample_size; ++i) {
+        sample.push_back(begin[i * size / selection_sample_size]);
+    }
+    auto middle = sample.begin() + selection_sample_size / 2;
+    std::nth_element(sample.begin(), middle, sample.end(), comp);
+    return *middle;
+}
+
+// n - 1 splitters that cut [begin, begin + size) into n buckets of about the
+// same size, picked from an evenly spread sample.
+template <typename RandomIt, typename Compare>
+std::vector<typename std::iterator_traits<RandomIt>::value_type>
+sample_splitters(RandomIt begin, std::size_t size, std::size_t n, Compare& comp)
+{
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+
+    const auto count = std::min(size, n * splitter_oversampling);
+    std::vector<value_type> sample;
+    sample.reserve(count);
+    for(std::size_t i = 0; i < count; ++i) { sample.push_back(begin[i * size / count]); }
+    std::sort(sample.begin(), sample.end(), comp);
+
+    std::vector<value_type> splitters;
+    splitters.reserve(n - 1);
+    for(std::size_t b = 1; b < n; ++b) { splitters.push_back(sample[b * count / n]); }
+    return splitters;
+}
+
+//================================================================================
+
+template <typename RandomIt, typename Compare>
+void nth_element_impl(
+    sequential_execution_policy, RandomIt begin, RandomIt nth, RandomIt end,
+    Compare comp
+)
+{
+    std::nth_element(begin, nth, end, comp);
+}
+
+template <typename RandomIt, typename Compare>
+void nth_element_impl(
+    parallel_execution_policy, RandomIt begin, RandomIt nth, RandomIt end,
+    Compare comp
+)
+{
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+
+    auto size = static_cast<std::size_t>(std::distance(begin, end));
+    if(size <= selection_sequential_cutoff || nth == end) {
+        std::nth_element(begin, nth, end, comp);
+        return;
+    }
+
+    std::vector<value_type> buffer(size);
+    std::vector<unsigned char> classes(size);
+
+    // Every pass keeps at least the pivot's equal group out of the remaining
+    // range, so this always terminates.
+    while(size > selection_sequential_cutoff) {
+        const auto pivot = sample_pivot(begin, size, comp);
+        const auto groups = partition_three_way(begin, size, pivot, comp, buffer, classes);
+        const auto target = static_cast<std::size_t>(std::distance(begin, nth));
+
+        if(target < groups.first) {
+            size = groups.first;
+        }
+        else if(target < groups.first + groups.second) {
+            return;
+        }
+        else {
+            begin += groups.first + groups.second;
+            size -= groups.first + groups.second;
+        }
+    }
+    std::nth_element(begin, nth, begin + size, comp);
+}
+
+template <typename RandomIt, typename Compare>
+void nth_element_impl(
+    parallel_vector_execution_policy, RandomIt begin, RandomIt nth, RandomIt end,
+    Compare comp
+)
+{
+    nth_element_impl(par, begin, nth, end, comp);
+}
+
+//================================================================================
+
+template <typename RandomIt, typename Compare>
+void partial_sort_impl(
+    sequential_execution_policy, RandomIt begin, RandomIt middle, RandomIt end,
+    Compare comp
+)
+{
+    std::partial_sort(begin, middle, end, comp);
+}
+
+// For a short [begin, middle): every chunk partially sorts itself, which
+// only takes a pass over the chunk with a heap of middle - begin elements,
+// and the leading elements are then picked from the chunks' sorted prefixes.
+// These are moved out, partially sorted and moved back into the same places,
+// the first chunk's prefix being [begin, middle). Returns false, doing
+// nothing, if the prefixes would be too long for this to pay off.
+template <typename RandomIt, typename Compare>
+bool partial_sort_heaps(RandomIt begin, RandomIt middle, RandomIt end, Compare& comp)
+{
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    const auto k = static_cast<std::size_t>(std::distance(begin, middle));
+    const auto n = chunk_count(size);
+    if(n < 2 || k * n * partial_sort_heap_ratio > size) { return false; }
+
+    for_each_chunk(size, n, [begin, k, &comp](std::size_t, std::size_t first, std::size_t last) {
+        std::partial_sort(begin + first, begin + first + k, begin + last, comp);
+    });
+
+    std::vector<value_type> candidates;
+    candidates.reserve(k * n);
+    for(std::size_t i = 0; i < n; ++i) {
+        auto first = begin + chunk_begin(i, n, size);
+        candidates.insert(candidates.end(), std::make_move_iterator(first),
+                          std::make_move_iterator(first + k));
+    }
+    std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), comp);
+    for(std::size_t i = 0; i < n; ++i) {
+        std::move(candidates.begin() + i * k, candidates.begin() + (i + 1) * k,
+                  begin + chunk_begin(i, n, size));
+    }
+    return true;
+}
+
+// Otherwise selects the leading elements, then sorts them with a single
+// sample sort pass: splitters picked from a sample cut them into as many
+// buckets as there are chunks, every chunk classifies its elements into the
+// buckets and moves them into their slots of the scratch buffer (at offsets
+// found by prefix sums over the per-chunk counts, as in partition_three_way),
+// and every bucket is then sorted and moved back on its own.
+template <typename RandomIt, typename Compare>
+void partial_sort_impl(
+    parallel_execution_policy, RandomIt begin, RandomIt middle, RandomIt end,
+    Compare comp
+)
+{
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+
+    if(begin == middle) { return; }
+    if(partial_sort_heaps(begin, middle, end, comp)) { return; }
+    if(middle != end) { nth_element_impl(par, begin, middle - 1, end, comp); }
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, middle));
+    if(size <= selection_sequential_cutoff) {
+        std::sort(begin, middle, comp);
+        return;
+    }
+
+    const auto n = chunk_count(size);
+    const auto splitters = sample_splitters(begin, size, n, comp);
+
+    // counts[i * n + b]: elements of chunk i that go to bucket b.
+    std::vector<std::size_t> counts(n * n);
+    std::vector<std::uint32_t> buckets(size);
+    for_each_chunk(size, n,
+        [begin, n, &splitters, &comp, &counts, &buckets](std::size_t i, std::size_t first, std::size_t last) {
+            auto* c = &counts[i * n];
+            for(auto j = first; j != last; ++j) {
+                const auto b = static_cast<std::size_t>(
+                    std::upper_bound(splitters.begin(), splitters.end(), begin[j], comp)
+                    - splitters.begin());
+                buckets[j] = static_cast<std::uint32_t>(b);
+                ++c[b];
+            }
+        });
+
+    // Turn the counts into every chunk's offset in each bucket, bucket by bucket.
+    std::vector<std::size_t> bucket_begin(n + 1);
+    std::size_t total = 0;
+    for(std::size_t b = 0; b < n; ++b) {
+        bucket_begin[b] = total;
+        for(std::size_t i = 0; i < n; ++i) { total += std::exchange(counts[i * n + b], total); }
+    }
+    bucket_begin[n] = total;
+
+    std::vector<value_type> buffer(size);
+    for_each_chunk(size, n,
+        [begin, n, &buffer, &counts, &buckets](std::size_t i, std::size_t first, std::size_t last) {
+            auto* offsets = &counts[i * n];
+            for(auto j = first; j != last; ++j) {
+                buffer[offsets[buckets[j]]++] = std::move(begin[j]);
+            }
+        });
+
+    for_each_chunk(n, n, [begin, &buffer, &bucket_begin, &comp](std::size_t b, std::size_t, std::size_t) {
+        auto first = buffer.begin() + bucket_begin[b];
+        auto last = buffer.begin() + bucket_begin[b + 1];
+        std::sort(first, last, comp);
+        std::move(first, last, begin + bucket_begin[b]);
+    });
+}
+
+template <typename RandomIt, typename Compare>
+void partial_sort_impl(
+    parallel_vector_execution_policy, RandomIt begin, RandomIt middle, RandomIt end,
+    Compare comp
+)
+{
+    partial_sort_impl(par, begin, middle, end, comp);
+}
+
+//================================================================================
+
+// The k greatest elements seen so far, as a heap whose top is the least of
+// them, so it can be replaced cheaply. Its storage grows as elements come in,
+// up to k, unless reserved up front.
+template <typename T, typename Compare>
+class bounded_heap
+{
+public:
+
+    bounded_heap(std::size_t k, Compare comp)
+        : k(k), greater{comp}
+    { }
+
+    void reserve(std::size_t n) { values.reserve(std::min(n, k)); }
+
+    template <typename U>
+    void push(U&& x)
+    {
+        if(values.size() < k) {
+            values.push_back(std::forward<U>(x));
+            std::push_heap(values.begin(), values.end(), greater);
+        }
+        else if(k > 0 && greater.comp(values.front(), x)) {
+            std::pop_heap(values.begin(), values.end(), greater);
+            values.back() = std::forward<U>(x);
+            std::push_heap(values.begin(), values.end(), greater);
+        }
+    }
+
+    void merge(bounded_heap&& other)
+    {
+        for(auto&& x : other.values) { push(std::move(x)); }
+    }
+
+    // Greatest first.
+    std::vector<T> sorted() &&
+    {
+        std::sort_heap(values.begin(), values.end(), greater);
+        return std::move(values);
+    }
+
+private:
+
+    struct inverse
+    {
+        Compare comp;
+
+        template <typename A, typename B>
+        bool operator()(const A& a, const B& b) { return comp(b, a); }
+    };
+
+    std::size_t k;
+    inverse greater;
+    std::vector<T> values;
+};
+
+template <typename InputIt, typename Compare>
+std::vector<typename std::iterator_traits<InputIt>::value_type>
+top_k_impl(
+    sequential_execution_policy, InputIt begin, InputIt end, std::size_t k,
+    Compare comp
+)
+{
+    using value_type = typename std::iterator_traits<InputIt>::value_type;
+
+    bounded_heap<value_type, Compare> heap(k, comp);
+    for(; begin != end; ++begin) { heap.push(*begin); }
+    return std::move(heap).sorted();
+}
+
+template <typename InputIt, typename Compare>
+std::vector<typename std::iterator_traits<InputIt>::value_type>
+top_k_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, std::size_t k,
+    Compare comp, enable_if_random<InputIt>* = 0
+)
+{
+    using value_type = typename std::iterator_traits<InputIt>::value_type;
+    using heap_type = bounded_heap<value_type, Compare>;
+
+    const auto size = static_cast<std::size_t>(std::distance(begin, end));
+    k = std::min(k, size);
+
+    std::vector<heap_type> heaps(chunk_count(size), heap_type(k, comp));
+    heaps[0].reserve(k);
+    for_each_chunk(size, [begin, &heaps](std::size_t i, std::size_t first, std::size_t last) {
+        auto begin_chunk = begin + first;
+        auto end_chunk = begin + last;
+        chunk_hint(begin_chunk, end_chunk);
+        heaps[i].reserve(last - first);
+        for(; begin_chunk != end_chunk; ++begin_chunk) { heaps[i].push(*begin_chunk); }
+    });
+
+    for(std::size_t i = 1; i < heaps.size(); ++i) { heaps[0].merge(std::move(heaps[i])); }
+    return std::move(heaps[0]).sorted();
+}
+
+template <typename InputIt, typename Compare>
+std::vector<typename std::iterator_traits<InputIt>::value_type>
+top_k_impl(
+    parallel_execution_policy, InputIt begin, InputIt end, std::size_t k,
+    Compare comp, enable_if_not_random<InputIt>* = 0
+)
+{
+    return top_k_impl(seq, begin, end, k, comp);
+}
+
+template <typename InputIt, typename Compare>
+std::vector<typename std::iterator_traits<InputIt>::value_type>
+top_k_impl(
+    parallel_vector_execution_policy, InputIt begin, InputIt end, std::size_t k,
+    Compare comp
+)
+{
+    return top_k_impl(par, begin, end, k, comp);
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename RandomIt, typename Compare>
+void nth_element(
+    ExecutionPolicy&& policy, RandomIt begin, RandomIt nth, RandomIt end, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    internal::nth_element_impl(policy, begin, nth, end, comp);
+}
+
+template <typename RandomIt, typename Compare>
+void nth_element(
+    execution_policy policy, RandomIt begin, RandomIt nth, RandomIt end, Compare comp
+)
+{
+    auto f = [begin, nth, end, comp](auto policy)
+             { return internal::nth_element_impl(policy, begin, nth, end, comp); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename RandomIt>
+void nth_element(
+    ExecutionPolicy&& policy, RandomIt begin, RandomIt nth, RandomIt end,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    internal::nth_element_impl(policy, begin, nth, end, std::less<>{});
+}
+
+template <typename RandomIt>
+void nth_element(
+    execution_policy policy, RandomIt begin, RandomIt nth, RandomIt end
+)
+{
+    nth_element(policy, begin, nth, end, std::less<>{});
+}
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename RandomIt, typename Compare>
+void partial_sort(
+    ExecutionPolicy&& policy, RandomIt begin, RandomIt middle, RandomIt end, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    internal::partial_sort_impl(policy, begin, middle, end, comp);
+}
+
+template <typename RandomIt, typename Compare>
+void partial_sort(
+    execution_policy policy, RandomIt begin, RandomIt middle, RandomIt end, Compare comp
+)
+{
+    auto f = [begin, middle, end, comp](auto policy)
+             { return internal::partial_sort_impl(policy, begin, middle, end, comp); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename RandomIt>
+void partial_sort(
+    ExecutionPolicy&& policy, RandomIt begin, RandomIt middle, RandomIt end,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    internal::partial_sort_impl(policy, begin, middle, end, std::less<>{});
+}
+
+template <typename RandomIt>
+void partial_sort(
+    execution_policy policy, RandomIt begin, RandomIt middle, RandomIt end
+)
+{
+    partial_sort(policy, begin, middle, end, std::less<>{});
+}
+
+//================================================================================
+
+// The k greatest elements of the range under comp, greatest first.
+template <typename ExecutionPolicy, typename InputIt, typename Compare>
+std::vector<typename std::iterator_traits<InputIt>::value_type>
+top_k(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, std::size_t k, Compare comp,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::top_k_impl(policy, begin, end, k, comp);
+}
+
+template <typename InputIt, typename Compare>
+std::vector<typename std::iterator_traits<InputIt>::value_type>
+top_k(
+    execution_policy policy, InputIt begin, InputIt end, std::size_t k, Compare comp
+)
+{
+    auto f = [begin, end, k, comp](auto policy)
+             { return internal::top_k_impl(policy, begin, end, k, comp); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename InputIt>
+std::vector<typename std::iterator_traits<InputIt>::value_type>
+top_k(
+    ExecutionPolicy&& policy, InputIt begin, InputIt end, std::size_t k,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::top_k_impl(policy, begin, end, k, std::less<>{});
+}
+
+template <typename InputIt>
+std::vector<typename std::iterator_traits<InputIt>::value_type>
+top_k(
+    execution_policy policy, InputIt begin, InputIt end, std::size_t k
+)
+{
+    return top_k(policy, begin, end, k, std::less<>{});
+}
+
+} // end namespace parallel
+} // end namespace experimental
@@ -0,0 +1,464 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "contiguous_iterator.hpp"
+#include "hardware_conc.hpp"
+#include "iterator_operators.hpp"
+#include "thread_pool.hpp"
+
+// Running an algorithm across several local worker processes over data kept
+// in POSIX shared memory:
+//
+//     using namespace experimental::parallel;
+//     shared_array<double> samples(n);
+//     ... fill samples ...
+//     auto total = reduce(par_shm, samples.begin(), samples.end(), 0.0);
+//     for_each(shared_memory_execution_policy(4), samples.begin(), samples.end(),
+//              [](double& x) { x *= 2; });
+//
+// Under par_shm the coordinating process splits the range into one part per
+// worker, forks a process for every part, and combines the partial results
+// the workers leave in a shared memory segment once they have all exited. A
+// worker that throws, crashes or is killed makes the call throw, without
+// taking the coordinator down with it.
+//
+// Only count, count_if, reduce and for_each accept par_shm; it is not one of
+// the alternatives of execution_policy. The workers see a copy-on-write
+// snapshot of the coordinator's memory, so count, count_if and reduce work
+// on any random access range, and their results must be trivially copyable.
+// for_each writes through the range, so its range must be a shared_array for
+// the writes to reach the coordinator.
+//
+// Every worker runs its part sequentially. As it is forked from a process
+// that may have other threads (e.g. the thread pool), the body must not use
+// the parallel policies or take locks that another thread could have held at
+// the time of the fork. This is POSIX only.
+
+namespace experimental
+{
+namespace parallel
+{
+
+//================================================================================
+
+class shared_memory_execution_policy
+{
+public:
+
+    constexpr shared_memory_execution_policy() = default;
+
+    // Splits the work over the given number of processes; 0 means one per
+    // hardware thread.
+    constexpr explicit shared_memory_execution_policy(unsigned workers)
+        : worker_count(workers)
+    { }
+
+    unsigned workers() const
+    {
+        return worker_count > 0 ? worker_count : get_hardware_concurrency_or_default();
+    }
+
+    void swap(shared_memory_execution_policy& other) { std::swap(worker_count, other.worker_count); }
+
+private:
+
+    unsigned worker_count = 0;
+};
+
+constexpr shared_memory_execution_policy par_shm{};
+
+//================================================================================
+
+template <typename T>
+class shared_iterator
+    : public internal::random_access_operators<shared_iterator<T>, std::ptrdiff_t>
+{
+public:
+
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_cv_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using pointer = T*;
+
+    shared_iterator() = default;
+
+    explicit shared_iterator(T* p)
+        : p(p)
+    { }
+
+    reference operator*() const { return *p; }
+    pointer operator->() const { return p; }
+    reference operator[](difference_type n) const { return p[n]; }
+
+    pointer get() const { return p; }
+
+    void advance(difference_type n) { p += n; }
+    difference_type distance_to(const shared_iterator& other) const
+    { return other.p - p; }
+    bool equal(const shared_iterator& other) const
+    { return p == other.p; }
+
+private:
+
+    T* p = nullptr;
+};
+
+namespace internal
+{
+
+template <typename T>
+struct is_contiguous_iterator<shared_iterator<T>>
+    : std::integral_constant<bool, true>
+{ };
+
+template <typename Iterator>
+struct is_shared_iterator
+    : std::integral_constant<bool, false>
+{ };
+
+template <typename T>
+struct is_shared_iterator<shared_iterator<T>>
+    : std::integral_constant<bool, true>
+{ };
+
+// A name for a new shared memory object, unique to this process.
+inline std::string shared_object_name()
+{
+    static std::atomic<unsigned long> next{0};
+    return "/experimental_parallel." + std::to_string(::getpid()) + '.'
+         + std::to_string(next.fetch_add(1, std::memory_order_relaxed));
+}
+
+} // end namespace internal
+
+//================================================================================
+
+// An array of size value-initialized Ts in a POSIX shared memory object,
+// mapped read-write. The array that creates the object removes it again when
+// it is destroyed; other processes can map it by name in the meantime.
+template <typename T>
+class shared_array
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "shared arrays can only hold trivially copyable types");
+
+public:
+
+    using value_type = T;
+    using iterator = shared_iterator<T>;
+    using const_iterator = shared_iterator<const T>;
+    using size_type = std::size_t;
+
+    // Creates a new object under a name unique to this process.
+    explicit shared_array(size_type size)
+        : object_name(internal::shared_object_name()), count(size), owner(true)
+    {
+        const int fd = ::shm_open(object_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if(fd < 0) { throw_errno("shm_open"); }
+        map(fd, true);
+    }
+
+    // Maps an object created by another shared_array of size elements.
+    shared_array(const std::string& name, size_type size)
+        : object_name(name), count(size), owner(false)
+    {
+        const int fd = ::shm_open(object_name.c_str(), O_RDWR, 0);
+        if(fd < 0) { throw_errno("shm_open"); }
+        map(fd, false);
+    }
+
+    shared_array(shared_array&& other) noexcept
+        : object_name(std::move(other.object_name)),
+          mapping(std::exchange(other.mapping, nullptr)),
+          count(std::exchange(other.count, 0)),
+          owner(std::exchange(other.owner, false))
+    { }
+
+    shared_array& operator=(shared_array&& other) noexcept
+    {
+        if(&other != this) {
+            release();
+            object_name = std::move(other.object_name);
+            mapping = std::exchange(other.mapping, nullptr);
+            count = std::exchange(other.count, 0);
+            owner = std::exchange(other.owner, false);
+        }
+        return *this;
+    }
+
+    shared_array(const shared_array&) = delete;
+    shared_array& operator=(const shared_array&) = delete;
+
+    ~shared_array()
+    {
+        release();
+    }
+
+    const std::string& name() const noexcept { return object_name; }
+
+    T* data() noexcept { return static_cast<T*>(mapping); }
+    const T* data() const noexcept { return static_cast<const T*>(mapping); }
+    size_type size() const noexcept { return count; }
+    bool empty() const noexcept { return count == 0; }
+
+    T& operator[](size_type i) noexcept { return data()[i]; }
+    const T& operator[](size_type i) const noexcept { return data()[i]; }
+
+    iterator begin() noexcept { return iterator(data()); }
+    iterator end() noexcept { return iterator(data() + count); }
+    const_iterator begin() const noexcept { return const_iterator(data()); }
+    const_iterator end() const noexcept { return const_iterator(data() + count); }
+
+private:
+
+    [[noreturn]] static void throw_errno(const char* what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    // Sizes (if created) and maps the object; closes fd either way. The
+    // object is zero filled on creation, which value-initializes trivial Ts.
+    void map(int fd, bool create)
+    {
+        const auto bytes = std::max<std::size_t>(1, count * sizeof(T));
+        if(create && ::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            fail(fd, "ftruncate");
+        }
+        void* addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(addr == MAP_FAILED) { fail(fd, "mmap"); }
+        mapping = addr;
+        // The mapping stays valid once the descriptor is closed.
+        ::close(fd);
+    }
+
+    [[noreturn]] void fail(int fd, const char* what)
+    {
+        const int err = errno;
+        ::close(fd);
+        if(owner) { ::shm_unlink(object_name.c_str()); }
+        throw std::system_error(err, std::generic_category(), what);
+    }
+
+    void release() noexcept
+    {
+        if(mapping) { ::munmap(mapping, std::max<std::size_t>(1, count * sizeof(T))); }
+        if(owner) { ::shm_unlink(object_name.c_str()); }
+        mapping = nullptr;
+        owner = false;
+    }
+
+    std::string object_name;
+    void* mapping = nullptr;
+    size_type count = 0;
+    bool owner = false;
+};
+
+namespace internal
+{
+
+//================================================================================
+
+// Waits for every child, and returns whether they all exited normally with
+// status 0.
+inline bool reap_workers(const std::vector<pid_t>& children)
+{
+    bool succeeded = true;
+    for(auto pid : children) {
+        int status = 0;
+        while(::waitpid(pid, &status, 0) < 0) {
+            if(errno != EINTR) { status = -1; break; }
+        }
+        succeeded = succeeded && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    return succeeded;
+}
+
+// Forks one process for each of the workers' parts of [0, size), each of
+// which runs work(first, last) and stores the result in a shared slot. Once
+// they have all exited, combine is called with the results in order.
+template <typename Result, typename Work, typename Combine>
+void run_in_workers(
+    const shared_memory_execution_policy& policy, std::size_t size, Work& work, Combine combine
+)
+{
+    static_assert(std::is_trivially_copyable<Result>::value,
+                  "results of par_shm kernels must be trivially copyable");
+
+    if(size == 0) { return; }
+
+    struct slot
+    {
+        Result value;
+        bool done;
+    };
+
+    const auto n = std::min<std::size_t>(policy.workers(), size);
+    shared_array<slot> slots(n);
+    std::vector<pid_t> children;
+    children.reserve(n);
+
+    for(std::size_t i = 0; i < n; ++i) {
+        const pid_t pid = ::fork();
+        if(pid < 0) {
+            const int err = errno;
+            for(auto child : children) { ::kill(child, SIGKILL); }
+            reap_workers(children);
+            throw std::system_error(err, std::generic_category(), "fork");
+        }
+        if(pid == 0) {
+            // _exit rather than exit: the coordinator's atexit handlers and
+            // buffered output are not the worker's to run or flush.
+            int status = 1;
+            try {
+                slots[i].value = work(chunk_begin(i, n, size), chunk_begin(i + 1, n, size));
+                slots[i].done = true;
+                status = 0;
+            }
+            catch(...) { }
+            ::_exit(status);
+        }
+        children.push_back(pid);
+    }
+
+    const bool succeeded = reap_workers(children);
+    for(std::size_t i = 0; i < n; ++i) {
+        if(!succeeded || !slots[i].done) {
+            throw std::runtime_error("a par_shm worker process failed");
+        }
+    }
+    for(std::size_t i = 0; i < n; ++i) { combine(slots[i].value); }
+}
+
+//================================================================================
+
+template <typename RandomIt, typename UnaryPredicate>
+typename std::iterator_traits<RandomIt>::difference_type
+count_if_impl(
+    const shared_memory_execution_policy& policy, RandomIt begin, RandomIt end,
+    UnaryPredicate p
+)
+{
+    using difference_type = typename std::iterator_traits<RandomIt>::difference_type;
+
+    auto work = [begin, &p](std::size_t first, std::size_t last) {
+        return std::count_if(begin + first, begin + last, p);
+    };
+    difference_type total = 0;
+    run_in_workers<difference_type>(policy, static_cast<std::size_t>(end - begin), work,
+                                    [&total](difference_type n) { total += n; });
+    return total;
+}
+
+template <typename RandomIt, typename T, typename BinaryOp>
+T reduce_impl(
+    const shared_memory_execution_policy& policy, RandomIt begin, RandomIt end,
+    T init, BinaryOp op
+)
+{
+    // Every part starts from its own first element, so init is folded in
+    // exactly once.
+    auto work = [begin, &op](std::size_t first, std::size_t last) {
+        T acc(*(begin + first));
+        for(auto it = begin + first + 1; it != begin + last; ++it) { acc = op(std::move(acc), *it); }
+        return acc;
+    };
+    run_in_workers<T>(policy, static_cast<std::size_t>(end - begin), work,
+                      [&init, &op](T& value) { init = op(std::move(init), std::move(value)); });
+    return init;
+}
+
+template <typename T, typename Func>
+void for_each_impl(
+    const shared_memory_execution_policy& policy,
+    shared_iterator<T> begin, shared_iterator<T> end, Func f
+)
+{
+    auto work = [begin, &f](std::size_t first, std::size_t last) {
+        std::for_each(begin + first, begin + last, f);
+        return true;
+    };
+    run_in_workers<bool>(policy, static_cast<std::size_t>(end - begin), work, [](bool) { });
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename RandomIt, typename T>
+typename std::iterator_traits<RandomIt>::difference_type
+count(
+    const shared_memory_execution_policy& policy, RandomIt begin, RandomIt end, const T& value
+)
+{
+    return internal::count_if_impl(policy, begin, end,
+                                   [&value](const auto& input) { return input == value; });
+}
+
+template <typename RandomIt, typename UnaryPredicate>
+typename std::iterator_traits<RandomIt>::difference_type
+count_if(
+    const shared_memory_execution_policy& policy, RandomIt begin, RandomIt end, UnaryPredicate p
+)
+{
+    return internal::count_if_impl(policy, begin, end, p);
+}
+
+template <typename RandomIt, typename T, typename BinaryOp>
+T reduce(
+    const shared_memory_execution_policy& policy, RandomIt begin, RandomIt end, T init, BinaryOp op
+)
+{
+    return internal::reduce_impl(policy, begin, end, std::move(init), op);
+}
+
+template <typename RandomIt, typename T>
+T reduce(
+    const shared_memory_execution_policy& policy, RandomIt begin, RandomIt end, T init
+)
+{
+    return internal::reduce_impl(policy, begin, end, std::move(init), std::plus<>{});
+}
+
+template <typename RandomIt>
+typename std::iterator_traits<RandomIt>::value_type
+reduce(
+    const shared_memory_execution_policy& policy, RandomIt begin, RandomIt end
+)
+{
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    return internal::reduce_impl(policy, begin, end, value_type(), std::plus<>{});
+}
+
+template <typename RandomIt, typename Func>
+void for_each(
+    const shared_memory_execution_policy& policy, RandomIt begin, RandomIt end, Func f
+)
+{
+    static_assert(internal::is_shared_iterator<RandomIt>::value,
+                  "for_each under par_shm needs a range in a shared_array");
+    internal::for_each_impl(policy, begin, end, f);
+}
+
+} // end namespace parallel
+} // end namespace experimental
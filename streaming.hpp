@@ -0,0 +1,227 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+// Streaming execution for iterators that can't be split up front (input
+// iterators such as std::istream_iterator, or forward iterators such as
+// std::list's). The calling thread acts as the producer: it pulls elements
+// into fixed-size blocks taken from a small pool of recycled blocks, and
+// hands every full block to the worker pool. When all blocks are in flight
+// the producer waits for one to come back (helping with queued work in the
+// meantime), which bounds memory use and applies backpressure to the source.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+constexpr std::size_t stream_block_size = 1024;
+
+template <typename InputIt>
+constexpr bool is_forward_v =
+    std::is_base_of<
+        std::forward_iterator_tag,
+        typename std::iterator_traits<InputIt>::iterator_category
+    >::value;
+
+// Forward iterators can be revisited, so blocks just hold iterators and the
+// workers see the real elements (and can modify them). Input iterators only
+// allow a single pass, so their values are copied into the block.
+template <typename InputIt>
+using stream_item =
+    typename std::conditional<
+        is_forward_v<InputIt>,
+        InputIt,
+        typename std::iterator_traits<InputIt>::value_type
+    >::type;
+
+template <typename InputIt>
+const InputIt& stream_source(const InputIt& it, std::true_type) { return it; }
+
+template <typename InputIt>
+decltype(auto) stream_source(const InputIt& it, std::false_type) { return *it; }
+
+template <typename InputIt>
+decltype(auto) stream_deref(const InputIt& it, std::true_type) { return *it; }
+
+template <typename Value>
+const Value& stream_deref(const Value& v, std::false_type) { return v; }
+
+//================================================================================
+
+// The elements of one block, as seen by a worker.
+template <typename InputIt>
+class stream_view
+{
+public:
+
+    using is_forward = std::integral_constant<bool, is_forward_v<InputIt>>;
+
+    stream_view(const std::vector<stream_item<InputIt>>& items, const std::atomic<bool>& stop)
+        : items(items), stop(stop)
+    { }
+
+    // Calls f on the elements in order until it returns false, which is
+    // returned, or the stream is stopped elsewhere.
+    template <typename Func>
+    bool for_each(Func& f) const
+    {
+        for(auto&& x : items) {
+            if(stop.load(std::memory_order_relaxed)) { break; }
+            if(!f(stream_deref(x, is_forward{}))) { return false; }
+        }
+        return true;
+    }
+
+private:
+
+    const std::vector<stream_item<InputIt>>& items;
+    const std::atomic<bool>& stop;
+};
+
+template <typename InputIt, typename Func>
+struct stream_state;
+
+template <typename InputIt, typename Func>
+struct stream_block
+    : public pool_task
+{
+    std::vector<stream_item<InputIt>> items;
+    stream_state<InputIt, Func>* state = nullptr;
+
+    void execute() noexcept override { state->process(*this); }
+};
+
+template <typename InputIt, typename Func>
+struct stream_state
+{
+    using block = stream_block<InputIt, Func>;
+    using is_forward = std::integral_constant<bool, is_forward_v<InputIt>>;
+
+    Func& f;
+    std::mutex m;
+    std::vector<block*> free_blocks;
+    std::atomic<std::size_t> in_flight{0};
+    std::atomic<bool> stop{false};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+
+    explicit stream_state(Func& f) : f(f) { }
+
+    void process(block& b) noexcept
+    {
+        try {
+            if(!f(stream_view<InputIt>(b.items, stop))) {
+                stop.store(true, std::memory_order_relaxed);
+            }
+        }
+        catch(...) {
+            if(!failed.exchange(true)) { error = std::current_exception(); }
+            stop.store(true, std::memory_order_relaxed);
+        }
+        b.items.clear();
+        {
+            std::lock_guard<std::mutex> lock(m);
+            free_blocks.push_back(&b);
+        }
+        in_flight.fetch_sub(1, std::memory_order_acq_rel);
+        thread_pool::instance().notify();
+    }
+
+    block* acquire()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        if(free_blocks.empty()) { return nullptr; }
+        block* b = free_blocks.back();
+        free_blocks.pop_back();
+        return b;
+    }
+
+    bool has_free_block()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        return !free_blocks.empty();
+    }
+};
+
+// Runs f on every block of elements of [begin, end) on the pool, as a
+// stream_view, so that it can keep block-local state. f returns false to stop
+// the whole stream early; elements that haven't been handed out by then are
+// never read from the source.
+template <typename InputIt, typename Func>
+void stream_for_each_block(InputIt begin, InputIt end, Func f)
+{
+    using state_type = stream_state<InputIt, Func>;
+    using block = typename state_type::block;
+    using is_forward = typename state_type::is_forward;
+
+    auto& pool = thread_pool::instance();
+    state_type state(f);
+
+    // Enough blocks to keep every worker busy while the producer fills more.
+    std::vector<block> blocks(2 * (pool.size() + 1));
+    for(auto&& b : blocks) {
+        b.state = &state;
+        b.items.reserve(stream_block_size);
+        state.free_blocks.push_back(&b);
+    }
+
+    auto drain = [&pool, &state] {
+        pool.help_until([&state] {
+            return state.in_flight.load(std::memory_order_acquire) == 0;
+        });
+    };
+
+    // If reading the source throws, the blocks already handed out still
+    // refer to state and f, so they are stopped and waited for first.
+    try {
+        while(begin != end && !state.stop.load(std::memory_order_relaxed)) {
+            block* b = state.acquire();
+            if(!b) {
+                pool.help_until([&state] { return state.has_free_block(); });
+                continue;
+            }
+            for(; begin != end && b->items.size() < stream_block_size; ++begin) {
+                b->items.push_back(stream_item<InputIt>(
+                    stream_source(begin, is_forward{})
+                ));
+            }
+            state.in_flight.fetch_add(1, std::memory_order_relaxed);
+            pool.submit(b);
+        }
+    }
+    catch(...) {
+        state.stop.store(true, std::memory_order_relaxed);
+        drain();
+        throw;
+    }
+
+    drain();
+    if(state.error) { std::rethrow_exception(state.error); }
+}
+
+// Runs f on every element of [begin, end) on the pool, with the early stop
+// of stream_for_each_block: once f returns false, the other blocks stop too.
+template <typename InputIt, typename Func>
+void stream_for_each(InputIt begin, InputIt end, Func f)
+{
+    stream_for_each_block(begin, end, [&f](const stream_view<InputIt>& block) {
+        return block.for_each(f);
+    });
+}
+
+} // end namespace internal
+} // end namespace parallel
+} // end namespace experimental
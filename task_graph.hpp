@@ -0,0 +1,233 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+// Runs a set of jobs, typically algorithm calls, as a dependency graph on the
+// shared worker pool:
+//
+//     using namespace experimental::parallel;
+//
+//     task_graph g;
+//     auto fill  = g.emplace([&] { generate_random(par, a.begin(), a.end(), dist, seed); });
+//     auto scale = g.emplace([&] { for_each(par, b.begin(), b.end(), scale_from_a); });
+//     auto cnt   = g.emplace([&] { n = count_if(par, b.begin(), b.end(), pred); });
+//     auto same  = g.emplace([&] { eq = equal(par, b.begin(), b.end(), c.begin(), c.end()); });
+//     fill.precede(scale);
+//     scale.precede(cnt, same);
+//     g.run();
+//
+// A job becomes ready when all of the jobs it depends on have finished, and
+// it is then queued on the pool right away, so that independent jobs overlap
+// and there is no global join between stages. Parallel algorithms called by a
+// job submit their chunks to the same pool and help with them as usual.
+// Whoever finishes the last dependency of a job goes on to run that job
+// itself, instead of queueing it and going back to the queue.
+//
+// run() waits for the whole graph, helping with queued tasks meanwhile, and
+// rethrows the first exception thrown by a job. Jobs that haven't started by
+// the time one throws are skipped. A graph can be run any number of times,
+// but mustn't be changed while it is running.
+
+namespace experimental
+{
+namespace parallel
+{
+
+class task_graph;
+
+namespace internal
+{
+
+//================================================================================
+
+class graph_node
+    : public pool_task
+{
+public:
+
+    graph_node(task_graph& graph, std::size_t index, std::function<void()> work)
+        : graph(graph), index(index), work(std::move(work))
+    { }
+
+    void execute() noexcept override;
+
+private:
+
+    friend class experimental::parallel::task_graph;
+
+    graph_node* run_one() noexcept;
+
+    task_graph& graph;
+    std::size_t index;
+    std::function<void()> work;
+    std::vector<graph_node*> successors;
+    std::size_t predecessors = 0;
+    std::atomic<std::size_t> waiting{0};
+};
+
+} // end namespace internal
+
+//================================================================================
+
+class task_graph
+{
+public:
+
+    // Refers to a job of the graph, to declare its dependencies.
+    class task_handle
+    {
+    public:
+
+        // others can only start after this one has finished.
+        template <typename... Handles>
+        task_handle& precede(Handles... others)
+        {
+            using expand = int[];
+            (void)expand{ 0, (link(node, others.node), 0)... };
+            return *this;
+        }
+
+        // This one can only start after all of others have finished.
+        template <typename... Handles>
+        task_handle& succeed(Handles... others)
+        {
+            using expand = int[];
+            (void)expand{ 0, (link(others.node, node), 0)... };
+            return *this;
+        }
+
+    private:
+
+        friend class task_graph;
+
+        explicit task_handle(internal::graph_node* node)
+            : node(node)
+        { }
+
+        static void link(internal::graph_node* from, internal::graph_node* to)
+        {
+            from->successors.push_back(to);
+            ++to->predecessors;
+        }
+
+        internal::graph_node* node;
+    };
+
+    task_graph() = default;
+
+    // Nodes point back at the graph.
+    task_graph(const task_graph&) = delete;
+    task_graph& operator=(const task_graph&) = delete;
+
+    template <typename Func>
+    task_handle emplace(Func&& f)
+    {
+        nodes.emplace_back(*this, nodes.size(), std::function<void()>(std::forward<Func>(f)));
+        return task_handle(&nodes.back());
+    }
+
+    std::size_t size() const noexcept { return nodes.size(); }
+
+    // Throws std::invalid_argument if the dependencies form a cycle.
+    void run()
+    {
+        if(nodes.empty()) { return; }
+        check_acyclic();
+
+        failed.store(false, std::memory_order_relaxed);
+        error = nullptr;
+        remaining.store(nodes.size(), std::memory_order_relaxed);
+        for(auto& n : nodes) { n.waiting.store(n.predecessors, std::memory_order_relaxed); }
+
+        auto& pool = internal::thread_pool::instance();
+        for(auto& n : nodes) {
+            if(n.predecessors == 0) { pool.submit(&n); }
+        }
+
+        pool.help_until([this] { return remaining.load(std::memory_order_acquire) == 0; });
+        if(error) { std::rethrow_exception(error); }
+    }
+
+private:
+
+    friend class internal::graph_node;
+
+    void check_acyclic() const
+    {
+        // Kahn's algorithm: every node is reached only if there is no cycle.
+        std::vector<std::size_t> waiting;
+        std::vector<const internal::graph_node*> ready;
+        waiting.reserve(nodes.size());
+        for(auto& n : nodes) {
+            waiting.push_back(n.predecessors);
+            if(n.predecessors == 0) { ready.push_back(&n); }
+        }
+
+        std::size_t reached = 0;
+        while(!ready.empty()) {
+            auto n = ready.back();
+            ready.pop_back();
+            ++reached;
+            for(auto s : n->successors) {
+                if(--waiting[s->index] == 0) { ready.push_back(s); }
+            }
+        }
+
+        if(reached != nodes.size()) {
+            throw std::invalid_argument("task_graph: dependencies form a cycle");
+        }
+    }
+
+    std::deque<internal::graph_node> nodes;
+    std::atomic<std::size_t> remaining{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+};
+
+namespace internal
+{
+
+//================================================================================
+
+inline void graph_node::execute() noexcept
+{
+    for(auto n = this; n; n = n->run_one()) { }
+}
+
+// Runs the job, releases its successors and returns one that has become
+// ready, if any, for the caller to run next.
+inline graph_node* graph_node::run_one() noexcept
+{
+    if(!graph.failed.load(std::memory_order_relaxed)) {
+        try { work(); }
+        catch(...) {
+            if(!graph.failed.exchange(true)) { graph.error = std::current_exception(); }
+        }
+    }
+
+    auto& pool = thread_pool::instance();
+    graph_node* next = nullptr;
+    for(auto s : successors) {
+        if(s->waiting.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            if(next) { pool.submit(next); }
+            next = s;
+        }
+    }
+
+    // The graph may be gone as soon as the last job is counted off.
+    if(graph.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) { pool.notify(); }
+    return next;
+}
+
+} // end namespace internal
+} // end namespace parallel
+} // end namespace experimental
@@ -0,0 +1,397 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hardware_conc.hpp"
+
+// A single process-wide pool of worker threads that every parallel algorithm
+// submits its chunks to. A thread that is waiting for its chunks to finish
+// runs queued tasks itself rather than blocking ("help while waiting"). This
+// matters for nested calls: a for_each(par, ...) body that itself calls
+// count_if(par, ...) enqueues its chunks into the same pool and keeps
+// working on them, so the number of threads stays bounded by the pool size
+// (plus the external callers) no matter how deep the nesting goes.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+// Intrusive node for the pool queue. Tasks are owned by whoever submits them,
+// and must stay alive until they have run.
+class pool_task
+{
+public:
+
+    virtual void execute() noexcept = 0;
+
+protected:
+
+    ~pool_task() = default;
+
+private:
+
+    friend class thread_pool;
+    pool_task* next = nullptr;
+};
+
+//================================================================================
+
+class thread_pool
+{
+public:
+
+    explicit thread_pool(unsigned num_workers)
+    {
+        workers.reserve(num_workers);
+        for(auto i = 0U; i < num_workers; ++i) {
+            workers.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        cv.notify_all();
+        for(auto&& w : workers) { w.join(); }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    static thread_pool& instance()
+    {
+        static thread_pool pool(get_hardware_concurrency_or_default());
+        return pool;
+    }
+
+    // True if the calling thread is one of the pool's workers, which means we
+    // are inside the body of an outer parallel algorithm.
+    static bool on_worker_thread() noexcept
+    {
+        return worker_flag();
+    }
+
+    unsigned size() const noexcept
+    {
+        return static_cast<unsigned>(workers.size());
+    }
+
+    void submit(pool_task* task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            push(task);
+        }
+        cv.notify_one();
+    }
+
+    template <typename Iterator>
+    void submit(Iterator first, Iterator last)
+    {
+        if(first == last) { return; }
+        {
+            std::lock_guard<std::mutex> lock(m);
+            for(; first != last; ++first) { push(&*first); }
+        }
+        cv.notify_all();
+    }
+
+    // Runs queued tasks on the calling thread until done() holds. Whoever
+    // makes done() true must call notify() afterwards.
+    template <typename Predicate>
+    void help_until(Predicate done)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        while(!done()) {
+            if(pool_task* task = pop()) {
+                lock.unlock();
+                task->execute();
+                lock.lock();
+                continue;
+            }
+            cv.wait(lock);
+        }
+    }
+
+    void notify()
+    {
+        std::lock_guard<std::mutex> lock(m);
+        cv.notify_all();
+    }
+
+private:
+
+    static bool& worker_flag() noexcept
+    {
+        thread_local bool is_worker = false;
+        return is_worker;
+    }
+
+    void worker_loop()
+    {
+        worker_flag() = true;
+        std::unique_lock<std::mutex> lock(m);
+        for(;;) {
+            if(pool_task* task = pop()) {
+                lock.unlock();
+                task->execute();
+                lock.lock();
+                continue;
+            }
+            if(stopping) { return; }
+            cv.wait(lock);
+        }
+    }
+
+    void push(pool_task* task)
+    {
+        task->next = nullptr;
+        if(tail) { tail->next = task; } else { head = task; }
+        tail = task;
+    }
+
+    pool_task* pop()
+    {
+        pool_task* task = head;
+        if(task) {
+            head = task->next;
+            if(!head) { tail = nullptr; }
+        }
+        return task;
+    }
+
+    std::mutex m;
+    std::condition_variable cv;
+    pool_task* head = nullptr;
+    pool_task* tail = nullptr;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+//================================================================================
+
+// Completion latch for a batch of tasks. The first exception thrown by any of
+// them is kept and rethrown from wait().
+class task_group
+{
+public:
+
+    explicit task_group(std::size_t count)
+        : pending(count)
+    { }
+
+    template <typename Func>
+    void run(Func&& f) noexcept
+    {
+        try { f(); }
+        catch(...) {
+            if(!failed.exchange(true)) { error = std::current_exception(); }
+        }
+        if(pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            thread_pool::instance().notify();
+        }
+    }
+
+    bool done() const noexcept
+    {
+        return pending.load(std::memory_order_acquire) == 0;
+    }
+
+    void wait()
+    {
+        thread_pool::instance().help_until([this] { return done(); });
+        if(error) { std::rethrow_exception(error); }
+    }
+
+private:
+
+    std::atomic<std::size_t> pending;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+};
+
+//================================================================================
+
+// Number of chunks a range of the given size is split into. Twice the
+// hardware concurrency gives some slack for uneven chunks, but never more
+// chunks than elements.
+inline std::size_t chunk_count(std::size_t size)
+{
+    const static std::size_t hc = 2 * get_hardware_concurrency_or_default();
+    return std::max<std::size_t>(1, std::min(hc, size));
+}
+
+// Called by the algorithms with the bounds of every chunk before they start
+// on it. This does nothing by default; iterator types that know something
+// about their storage (e.g. memory-mapped files) overload it, to be found by
+// argument dependent lookup, to issue prefetch hints for the chunk.
+template <typename Iterator>
+void chunk_hint(Iterator, Iterator) noexcept
+{ }
+
+// Bounds of chunk i out of n over [0, size). The remainder of the division
+// goes one element at a time to the first chunks.
+inline std::size_t chunk_begin(std::size_t i, std::size_t n, std::size_t size)
+{
+    return i * (size / n) + std::min(i, size % n);
+}
+
+// Chunk bookkeeping lives on the caller's stack for up to this many chunks,
+// so that a parallel call doesn't touch the heap on machines with up to 64
+// hardware threads. Partial results larger than inline_slot_size always go
+// to the heap, so as not to put large arrays on the stack.
+constexpr std::size_t inline_chunk_capacity = 128;
+constexpr std::size_t inline_slot_size = 64;
+
+// Fixed-size array of up to capacity elements constructed one by one, kept
+// in place when capacity <= Inline and on the heap otherwise. Elements are
+// never moved, so they can be handed out to other threads.
+template <typename T, std::size_t Inline>
+class inline_buffer
+{
+public:
+
+    explicit inline_buffer(std::size_t capacity)
+        : data(capacity <= Inline
+                   ? reinterpret_cast<T*>(storage)
+                   : std::allocator<T>().allocate(capacity)),
+          capacity(capacity)
+    { }
+
+    inline_buffer(const inline_buffer&) = delete;
+    inline_buffer& operator=(const inline_buffer&) = delete;
+
+    ~inline_buffer()
+    {
+        while(count > 0) { data[--count].~T(); }
+        if(capacity > Inline) { std::allocator<T>().deallocate(data, capacity); }
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        ::new(static_cast<void*>(data + count)) T(std::forward<Args>(args)...);
+        return data[count++];
+    }
+
+    T& operator[](std::size_t i) { return data[i]; }
+
+    T* begin() { return data; }
+    T* end() { return data + count; }
+
+private:
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage[Inline];
+    T* data;
+    std::size_t capacity;
+    std::size_t count = 0;
+};
+
+// Inline capacity of an inline_buffer of per-chunk results of type T.
+template <typename T>
+constexpr std::size_t inline_slots =
+    sizeof(T) <= inline_slot_size ? inline_chunk_capacity : 1;
+
+template <typename Func>
+class chunk_task
+    : public pool_task
+{
+public:
+
+    chunk_task(Func& f, task_group& group, std::size_t index,
+               std::size_t first, std::size_t last)
+        : f(&f), group(&group), index(index), first(first), last(last)
+    { }
+
+    void execute() noexcept override
+    {
+        group->run([this] { (*f)(index, first, last); });
+    }
+
+private:
+
+    Func* f;
+    task_group* group;
+    std::size_t index;
+    std::size_t first;
+    std::size_t last;
+};
+
+// Splits [0, size) into n chunks (at most size, at least one) and calls
+// f(i, first, last) for each of them on the pool. The calling thread runs the
+// first chunk itself and then helps with the others until all of them are
+// done.
+template <typename Func>
+void for_each_chunk(std::size_t size, std::size_t n, Func f)
+{
+    n = std::max<std::size_t>(1, std::min(n, size));
+    task_group group(n);
+    inline_buffer<chunk_task<Func>, inline_chunk_capacity> tasks(n - 1);
+
+    for(std::size_t i = 1; i < n; ++i) {
+        tasks.emplace_back(f, group, i,
+            chunk_begin(i, n, size), chunk_begin(i + 1, n, size));
+    }
+
+    thread_pool::instance().submit(tasks.begin(), tasks.end());
+    group.run([&f, n, size] { f(0, 0, chunk_begin(1, n, size)); });
+    group.wait();
+}
+
+// As above, with chunk_count(size) chunks.
+template <typename Func>
+void for_each_chunk(std::size_t size, Func f)
+{
+    for_each_chunk(size, chunk_count(size), std::move(f));
+}
+
+// Maps every one of n chunks to a partial result with f(first, last), then
+// folds the partial results in chunk order with combine.
+// (Partial results are wrapped so that T = bool doesn't end up in a packed
+// std::vector<bool>, which chunks couldn't write to concurrently.)
+template <typename T, typename Func, typename Combine>
+T reduce_chunks(std::size_t size, std::size_t n, T init, Func f, Combine combine)
+{
+    struct slot { T value; };
+    n = std::max<std::size_t>(1, std::min(n, size));
+    inline_buffer<slot, inline_slots<slot>> partial(n);
+    for(std::size_t i = 0; i < n; ++i) { partial.emplace_back(slot{init}); }
+    for_each_chunk(size, n,
+        [&partial, &f](std::size_t i, std::size_t first, std::size_t last)
+        { partial[i].value = f(first, last); });
+
+    T result = init;
+    for(auto&& p : partial) { result = combine(result, p.value); }
+    return result;
+}
+
+// As above, with chunk_count(size) chunks.
+template <typename T, typename Func, typename Combine>
+T reduce_chunks(std::size_t size, T init, Func f, Combine combine)
+{
+    return reduce_chunks(size, chunk_count(size), std::move(init), std::move(f),
+                         std::move(combine));
+}
+
+} // end namespace internal
+} // end namespace parallel
+} // end namespace experimental
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "thread_pool.hpp"
+
+// Tiled iteration over 2D and 3D index spaces:
+//
+//     using namespace experimental::parallel;
+//     extents<2> image{ height, width };
+//     for_each_tile(par, image, cache_tile<2>(sizeof(float)),
+//         [&](std::size_t y, std::size_t x) { out[y * width + x] = blur(in, y, x); },
+//         tile_order::hilbert);
+//
+// The index space is cut into tiles of tile_shape (the ones along the upper
+// edges may be smaller), and the body is called with the indices of every
+// element of a tile before moving on to the next, so that a stencil reading
+// the neighbours of each element finds them in cache. The last index is the
+// innermost (contiguous) one. cache_tile picks a shape that fits a given
+// cache, half of L1 by default.
+//
+// The tiles are visited in row major order, or along a Morton (Z-order) or
+// Hilbert curve, which keep consecutive tiles close together in every
+// dimension. Under par and par_vec each worker gets a run of consecutive
+// tiles in that order; par_vec also asks the compiler to vectorize the
+// innermost loop, so its body must not depend on the order of the calls
+// within a row.
+
+namespace experimental
+{
+namespace parallel
+{
+
+template <std::size_t Rank>
+using extents = std::array<std::size_t, Rank>;
+
+enum class tile_order
+{
+    row_major,
+    morton,
+    hilbert
+};
+
+namespace internal
+{
+
+//================================================================================
+
+constexpr std::size_t l1_data_cache_size = 32 * 1024;
+
+// The tiles of an index space, numbered in row major order.
+template <std::size_t Rank>
+class tile_grid
+{
+public:
+
+    tile_grid(const extents<Rank>& size, const extents<Rank>& shape)
+        : size(size), shape(shape)
+    {
+        for(std::size_t d = 0; d < Rank; ++d) {
+            this->shape[d] = std::max<std::size_t>(1, shape[d]);
+            tiles[d] = (size[d] + this->shape[d] - 1) / this->shape[d];
+        }
+    }
+
+    std::size_t count() const
+    {
+        return std::accumulate(tiles.begin(), tiles.end(), std::size_t(1),
+                               std::multiplies<>{});
+    }
+
+    // Tile coordinates of tile t.
+    extents<Rank> coordinates(std::size_t t) const
+    {
+        extents<Rank> c;
+        for(std::size_t d = Rank; d-- > 0; ) {
+            c[d] = t % tiles[d];
+            t /= tiles[d];
+        }
+        return c;
+    }
+
+    // Bits needed for the largest tile coordinate.
+    unsigned coordinate_bits() const
+    {
+        const auto largest = *std::max_element(tiles.begin(), tiles.end());
+        unsigned bits = 1;
+        while((std::size_t(1) << bits) < largest) { ++bits; }
+        return bits;
+    }
+
+    // Element bounds [lo, hi) of the tile at coordinates c.
+    void bounds(const extents<Rank>& c, extents<Rank>& lo, extents<Rank>& hi) const
+    {
+        for(std::size_t d = 0; d < Rank; ++d) {
+            lo[d] = c[d] * shape[d];
+            hi[d] = std::min(size[d], lo[d] + shape[d]);
+        }
+    }
+
+private:
+
+    extents<Rank> size;
+    extents<Rank> shape;
+    extents<Rank> tiles;
+};
+
+//================================================================================
+
+// Interleaves the low bits of the coordinates, the first coordinate's bit
+// most significant within each group.
+template <std::size_t Rank>
+std::uint64_t morton_key(const extents<Rank>& c, unsigned bits)
+{
+    std::uint64_t key = 0;
+    for(unsigned b = bits; b-- > 0; ) {
+        for(std::size_t d = 0; d < Rank; ++d) {
+            key = (key << 1) | ((c[d] >> b) & 1);
+        }
+    }
+    return key;
+}
+
+// Position along the Hilbert curve through a 2^bits cube: Skilling's
+// transform of the coordinates into the "transposed" Hilbert index, whose
+// bits are then interleaved like a Morton key.
+template <std::size_t Rank>
+std::uint64_t hilbert_key(extents<Rank> x, unsigned bits)
+{
+    const std::size_t top = std::size_t(1) << (bits - 1);
+
+    for(auto q = top; q > 1; q >>= 1) {
+        const auto p = q - 1;
+        for(std::size_t d = 0; d < Rank; ++d) {
+            if(x[d] & q) {
+                x[0] ^= p;
+            }
+            else {
+                const auto t = (x[0] ^ x[d]) & p;
+                x[0] ^= t;
+                x[d] ^= t;
+            }
+        }
+    }
+
+    for(std::size_t d = 1; d < Rank; ++d) { x[d] ^= x[d - 1]; }
+    std::size_t t = 0;
+    for(auto q = top; q > 1; q >>= 1) {
+        if(x[Rank - 1] & q) { t ^= q - 1; }
+    }
+    for(auto& xd : x) { xd ^= t; }
+
+    return morton_key(x, bits);
+}
+
+// The tiles in visiting order; empty for row major, where a tile's position
+// is its number.
+template <std::size_t Rank>
+std::vector<std::size_t> tile_sequence(const tile_grid<Rank>& grid, tile_order order)
+{
+    std::vector<std::size_t> tiles;
+    if(order == tile_order::row_major) { return tiles; }
+
+    const auto count = grid.count();
+    const auto bits = grid.coordinate_bits();
+    std::vector<std::uint64_t> keys(count);
+    for(std::size_t t = 0; t < count; ++t) {
+        const auto c = grid.coordinates(t);
+        keys[t] = order == tile_order::morton ? morton_key(c, bits) : hilbert_key(c, bits);
+    }
+
+    tiles.resize(count);
+    std::iota(tiles.begin(), tiles.end(), std::size_t(0));
+    std::sort(tiles.begin(), tiles.end(),
+              [&keys](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+    return tiles;
+}
+
+//================================================================================
+
+template <typename Func, std::size_t Rank, std::size_t... Is>
+void tile_row(
+    Func& f, extents<Rank> index, std::size_t first, std::size_t last,
+    std::false_type /* vectorize */, std::index_sequence<Is...>
+)
+{
+    for(auto j = first; j < last; ++j) { f(index[Is]..., j); }
+}
+
+template <typename Func, std::size_t Rank, std::size_t... Is>
+void tile_row(
+    Func& f, extents<Rank> index, std::size_t first, std::size_t last,
+    std::true_type /* vectorize */, std::index_sequence<Is...>
+)
+{
+#if defined(__clang__)
+#pragma clang loop vectorize(enable)
+#elif defined(__GNUC__)
+#pragma GCC ivdep
+#endif
+    for(auto j = first; j < last; ++j) { f(index[Is]..., j); }
+}
+
+// Calls f for every element of [lo, hi), one innermost row at a time.
+template <typename Func, std::size_t Rank, typename Vectorize>
+void run_tile(Func& f, const extents<Rank>& lo, const extents<Rank>& hi, Vectorize vectorize)
+{
+    auto index = lo;
+    for(;;) {
+        tile_row(f, index, lo[Rank - 1], hi[Rank - 1], vectorize,
+                 std::make_index_sequence<Rank - 1>{});
+
+        // Step the outer indices like an odometer.
+        std::size_t d = Rank - 1;
+        for(;;) {
+            if(d == 0) { return; }
+            --d;
+            if(++index[d] != hi[d]) { break; }
+            index[d] = lo[d];
+        }
+    }
+}
+
+// Runs the tiles at positions [first, last) of the visiting order.
+template <typename Func, std::size_t Rank, typename Vectorize>
+void run_tiles(
+    Func& f, const tile_grid<Rank>& grid, const std::vector<std::size_t>& sequence,
+    std::size_t first, std::size_t last, Vectorize vectorize
+)
+{
+    extents<Rank> lo, hi;
+    for(auto i = first; i != last; ++i) {
+        grid.bounds(grid.coordinates(sequence.empty() ? i : sequence[i]), lo, hi);
+        run_tile(f, lo, hi, vectorize);
+    }
+}
+
+template <typename Func, std::size_t Rank, typename Vectorize>
+void run_tiles_parallel(
+    Func& f, const tile_grid<Rank>& grid, tile_order order, Vectorize vectorize
+)
+{
+    const auto sequence = tile_sequence(grid, order);
+    for_each_chunk(grid.count(),
+        [&f, &grid, &sequence, vectorize](std::size_t, std::size_t first, std::size_t last) {
+            run_tiles(f, grid, sequence, first, last, vectorize);
+        });
+}
+
+//================================================================================
+
+template <std::size_t Rank, typename Func>
+void for_each_tile_impl(
+    sequential_execution_policy, const extents<Rank>& size, const extents<Rank>& shape,
+    Func f, tile_order order
+)
+{
+    const tile_grid<Rank> grid(size, shape);
+    run_tiles(f, grid, tile_sequence(grid, order), 0, grid.count(), std::false_type{});
+}
+
+template <std::size_t Rank, typename Func>
+void for_each_tile_impl(
+    parallel_execution_policy, const extents<Rank>& size, const extents<Rank>& shape,
+    Func f, tile_order order
+)
+{
+    run_tiles_parallel(f, tile_grid<Rank>(size, shape), order, std::false_type{});
+}
+
+template <std::size_t Rank, typename Func>
+void for_each_tile_impl(
+    parallel_vector_execution_policy, const extents<Rank>& size, const extents<Rank>& shape,
+    Func f, tile_order order
+)
+{
+    run_tiles_parallel(f, tile_grid<Rank>(size, shape), order, std::true_type{});
+}
+
+} // end namespace internal
+
+//================================================================================
+
+// A tile shape whose elements of element_size fit in cache_bytes: as close
+// to a cube as powers of two allow, with any slack going to the innermost
+// dimension.
+template <std::size_t Rank>
+extents<Rank> cache_tile(
+    std::size_t element_size, std::size_t cache_bytes = internal::l1_data_cache_size / 2
+)
+{
+    static_assert(Rank > 0, "a tile needs at least one dimension");
+
+    const auto elements = std::max<std::size_t>(1, cache_bytes / std::max<std::size_t>(1, element_size));
+    auto volume = [](const extents<Rank>& e) {
+        return std::accumulate(e.begin(), e.end(), std::size_t(1), std::multiplies<>{});
+    };
+
+    extents<Rank> tile;
+    tile.fill(1);
+    for(;;) {
+        auto bigger = tile;
+        for(auto& t : bigger) { t *= 2; }
+        if(volume(bigger) > elements) { break; }
+        tile = bigger;
+    }
+    while(volume(tile) * 2 <= elements) { tile[Rank - 1] *= 2; }
+    return tile;
+}
+
+template <typename ExecutionPolicy, std::size_t Rank, typename Func>
+void for_each_tile(
+    ExecutionPolicy&& policy, const extents<Rank>& size, const extents<Rank>& tile_shape,
+    Func f, tile_order order = tile_order::row_major,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    static_assert(Rank > 0, "for_each_tile needs at least one dimension");
+    internal::for_each_tile_impl(policy, size, tile_shape, f, order);
+}
+
+template <std::size_t Rank, typename Func>
+void for_each_tile(
+    execution_policy policy, const extents<Rank>& size, const extents<Rank>& tile_shape,
+    Func f, tile_order order = tile_order::row_major
+)
+{
+    auto func = [&size, &tile_shape, f, order](auto policy)
+                { internal::for_each_tile_impl(policy, size, tile_shape, f, order); };
+    internal::dispatch(policy, func);
+}
+
+} // end namespace parallel
+} // end namespace experimental
@@ -0,0 +1,476 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "thread_pool.hpp"
+
+// Construction and destruction of objects in raw memory:
+//
+//     using namespace experimental::parallel;
+//     auto* raw = static_cast<std::string*>(::operator new(n * sizeof(std::string)));
+//     uninitialized_move(par, old, old + n, raw);
+//     ...
+//     destroy(par, raw, raw + n);
+//
+// Under par every chunk constructs its part of the destination with the
+// sequential algorithm, which already destroys whatever it has constructed
+// if a constructor throws. If any chunk fails, chunks that haven't started
+// yet are skipped, every chunk that completed is destroyed again, and the
+// first exception is rethrown, so that on failure no objects are left in the
+// destination, as with the standard algorithms.
+//
+// Iterators that aren't random access (both the source and the destination,
+// where there is a source) are handled sequentially.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+template <typename Iterator>
+constexpr bool is_random_iterator_v =
+    std::is_same<
+        typename std::iterator_traits<Iterator>::iterator_category,
+        std::random_access_iterator_tag
+    >::value;
+
+template <typename Iterator1, typename Iterator2>
+using enable_if_random_pair =
+    typename std::enable_if<
+        is_random_iterator_v<Iterator1> && is_random_iterator_v<Iterator2>
+    >::type;
+
+template <typename Iterator1, typename Iterator2>
+using enable_if_not_random_pair =
+    typename std::enable_if<
+        !(is_random_iterator_v<Iterator1> && is_random_iterator_v<Iterator2>)
+    >::type;
+
+template <typename ForwardIt>
+using iter_value_t = typename std::iterator_traits<ForwardIt>::value_type;
+
+//================================================================================
+
+template <typename ForwardIt>
+void destroy_range(ForwardIt first, ForwardIt last)
+{
+    using T = iter_value_t<ForwardIt>;
+    if(std::is_trivially_destructible<T>::value) { return; }
+    for(; first != last; ++first) { std::addressof(*first)->~T(); }
+}
+
+template <typename ForwardIt>
+void value_construct_range(ForwardIt first, ForwardIt last)
+{
+    using T = iter_value_t<ForwardIt>;
+    auto current = first;
+    try {
+        for(; current != last; ++current) {
+            ::new(static_cast<void*>(std::addressof(*current))) T();
+        }
+    }
+    catch(...) {
+        destroy_range(first, current);
+        throw;
+    }
+}
+
+// Calls construct(first, last) for chunks [first, last) of [0, size) on the
+// pool; construct must leave nothing constructed in its chunk if it throws.
+// If any chunk throws, the chunks that did complete are destroyed again
+// before the exception is rethrown.
+template <typename ForwardIt, typename Construct>
+void construct_chunks(ForwardIt dest, std::size_t size, Construct construct)
+{
+    if(size == 0) { return; }
+
+    struct slot { bool done; };
+    const auto n = chunk_count(size);
+    inline_buffer<slot, inline_slots<slot>> chunks(n);
+    for(std::size_t i = 0; i < n; ++i) { chunks.emplace_back(slot{false}); }
+    std::atomic<bool> failed{false};
+
+    try {
+        for_each_chunk(size, n,
+            [dest, &construct, &chunks, &failed](std::size_t i, std::size_t first, std::size_t last) {
+                if(failed.load(std::memory_order_relaxed)) { return; }
+                chunk_hint(dest + first, dest + last);
+                try { construct(first, last); }
+                catch(...) {
+                    failed.store(true, std::memory_order_relaxed);
+                    throw;
+                }
+                chunks[i].done = true;
+            });
+    }
+    catch(...) {
+        for(std::size_t i = 0; i < n; ++i) {
+            if(chunks[i].done) {
+                destroy_range(dest + chunk_begin(i, n, size), dest + chunk_begin(i + 1, n, size));
+            }
+        }
+        throw;
+    }
+}
+
+//================================================================================
+//=======================Sequential Execution Policy==============================
+//================================================================================
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_copy_impl(
+    sequential_execution_policy, InputIt first, InputIt last, ForwardIt d_first
+)
+{
+    return std::uninitialized_copy(first, last, d_first);
+}
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_move_impl(
+    sequential_execution_policy, InputIt first, InputIt last, ForwardIt d_first
+)
+{
+    return std::uninitialized_copy(
+        std::make_move_iterator(first), std::make_move_iterator(last), d_first);
+}
+
+template <typename ForwardIt, typename T>
+void uninitialized_fill_impl(
+    sequential_execution_policy, ForwardIt first, ForwardIt last, const T& value
+)
+{
+    std::uninitialized_fill(first, last, value);
+}
+
+template <typename ForwardIt>
+void uninitialized_value_construct_impl(
+    sequential_execution_policy, ForwardIt first, ForwardIt last
+)
+{
+    value_construct_range(first, last);
+}
+
+template <typename ForwardIt>
+void destroy_impl(sequential_execution_policy, ForwardIt first, ForwardIt last)
+{
+    destroy_range(first, last);
+}
+
+//================================================================================
+//========================Parallel Execution Policy===============================
+//================================================================================
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_copy_impl(
+    parallel_execution_policy, InputIt first, InputIt last, ForwardIt d_first,
+    enable_if_random_pair<InputIt, ForwardIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(first, last));
+    construct_chunks(d_first, size, [first, d_first](std::size_t b, std::size_t e) {
+        std::uninitialized_copy(first + b, first + e, d_first + b);
+    });
+    return d_first + size;
+}
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_copy_impl(
+    parallel_execution_policy, InputIt first, InputIt last, ForwardIt d_first,
+    enable_if_not_random_pair<InputIt, ForwardIt>* = 0
+)
+{
+    return uninitialized_copy_impl(seq, first, last, d_first);
+}
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_move_impl(
+    parallel_execution_policy, InputIt first, InputIt last, ForwardIt d_first,
+    enable_if_random_pair<InputIt, ForwardIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(first, last));
+    construct_chunks(d_first, size, [first, d_first](std::size_t b, std::size_t e) {
+        uninitialized_move_impl(seq, first + b, first + e, d_first + b);
+    });
+    return d_first + size;
+}
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_move_impl(
+    parallel_execution_policy, InputIt first, InputIt last, ForwardIt d_first,
+    enable_if_not_random_pair<InputIt, ForwardIt>* = 0
+)
+{
+    return uninitialized_move_impl(seq, first, last, d_first);
+}
+
+template <typename ForwardIt, typename T>
+void uninitialized_fill_impl(
+    parallel_execution_policy, ForwardIt first, ForwardIt last, const T& value,
+    enable_if_random_pair<ForwardIt, ForwardIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(first, last));
+    construct_chunks(first, size, [first, &value](std::size_t b, std::size_t e) {
+        std::uninitialized_fill(first + b, first + e, value);
+    });
+}
+
+template <typename ForwardIt, typename T>
+void uninitialized_fill_impl(
+    parallel_execution_policy, ForwardIt first, ForwardIt last, const T& value,
+    enable_if_not_random_pair<ForwardIt, ForwardIt>* = 0
+)
+{
+    uninitialized_fill_impl(seq, first, last, value);
+}
+
+template <typename ForwardIt>
+void uninitialized_value_construct_impl(
+    parallel_execution_policy, ForwardIt first, ForwardIt last,
+    enable_if_random_pair<ForwardIt, ForwardIt>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(first, last));
+    construct_chunks(first, size, [first](std::size_t b, std::size_t e) {
+        value_construct_range(first + b, first + e);
+    });
+}
+
+template <typename ForwardIt>
+void uninitialized_value_construct_impl(
+    parallel_execution_policy, ForwardIt first, ForwardIt last,
+    enable_if_not_random_pair<ForwardIt, ForwardIt>* = 0
+)
+{
+    value_construct_range(first, last);
+}
+
+// Trivially destructible objects need no work at all, so there is nothing
+// to split up for them.
+template <typename ForwardIt>
+void destroy_impl(
+    parallel_execution_policy, ForwardIt first, ForwardIt last,
+    enable_if_random_pair<ForwardIt, ForwardIt>* = 0
+)
+{
+    if(std::is_trivially_destructible<iter_value_t<ForwardIt>>::value) { return; }
+
+    const auto size = static_cast<std::size_t>(std::distance(first, last));
+    for_each_chunk(size, [first](std::size_t, std::size_t b, std::size_t e) {
+        chunk_hint(first + b, first + e);
+        destroy_range(first + b, first + e);
+    });
+}
+
+template <typename ForwardIt>
+void destroy_impl(
+    parallel_execution_policy, ForwardIt first, ForwardIt last,
+    enable_if_not_random_pair<ForwardIt, ForwardIt>* = 0
+)
+{
+    destroy_range(first, last);
+}
+
+//================================================================================
+//=====================Parallel Vector Execution Policy===========================
+//================================================================================
+
+// Constructors and destructors are arbitrary code, so there is nothing to
+// vectorize beyond what the sequential algorithms already do for trivial
+// types.
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_copy_impl(
+    parallel_vector_execution_policy, InputIt first, InputIt last, ForwardIt d_first
+)
+{ return uninitialized_copy_impl(par, first, last, d_first); }
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_move_impl(
+    parallel_vector_execution_policy, InputIt first, InputIt last, ForwardIt d_first
+)
+{ return uninitialized_move_impl(par, first, last, d_first); }
+
+template <typename ForwardIt, typename T>
+void uninitialized_fill_impl(
+    parallel_vector_execution_policy, ForwardIt first, ForwardIt last, const T& value
+)
+{ uninitialized_fill_impl(par, first, last, value); }
+
+template <typename ForwardIt>
+void uninitialized_value_construct_impl(
+    parallel_vector_execution_policy, ForwardIt first, ForwardIt last
+)
+{ uninitialized_value_construct_impl(par, first, last); }
+
+template <typename ForwardIt>
+void destroy_impl(parallel_vector_execution_policy, ForwardIt first, ForwardIt last)
+{ destroy_impl(par, first, last); }
+
+//================================================================================
+
+// Uninitialized storage for size Ts, for algorithms that go through a
+// temporary copy of their range; data() is null if it couldn't be
+// allocated. The first constructed() elements are destroyed (in parallel)
+// along with the buffer.
+template <typename T>
+class raw_buffer
+{
+public:
+
+    explicit raw_buffer(std::size_t size)
+        : first(static_cast<T*>(::operator new(size * sizeof(T), std::nothrow)))
+    { }
+
+    raw_buffer(const raw_buffer&) = delete;
+    raw_buffer& operator=(const raw_buffer&) = delete;
+
+    ~raw_buffer()
+    {
+        if(!first) { return; }
+        destroy_impl(par, first, first + count);
+        ::operator delete(first);
+    }
+
+    T* data() const noexcept { return first; }
+
+    void constructed(std::size_t n) noexcept { count = n; }
+
+private:
+
+    T* first;
+    std::size_t count = 0;
+};
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_copy(
+    ExecutionPolicy&& policy, InputIt first, InputIt last, ForwardIt d_first,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::uninitialized_copy_impl(policy, first, last, d_first);
+}
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_copy(
+    execution_policy policy, InputIt first, InputIt last, ForwardIt d_first
+)
+{
+    auto f = [first, last, d_first](auto policy)
+             { return internal::uninitialized_copy_impl(policy, first, last, d_first); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_move(
+    ExecutionPolicy&& policy, InputIt first, InputIt last, ForwardIt d_first,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::uninitialized_move_impl(policy, first, last, d_first);
+}
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_move(
+    execution_policy policy, InputIt first, InputIt last, ForwardIt d_first
+)
+{
+    auto f = [first, last, d_first](auto policy)
+             { return internal::uninitialized_move_impl(policy, first, last, d_first); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt, typename T>
+void uninitialized_fill(
+    ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, const T& value,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    internal::uninitialized_fill_impl(policy, first, last, value);
+}
+
+template <typename ForwardIt, typename T>
+void uninitialized_fill(
+    execution_policy policy, ForwardIt first, ForwardIt last, const T& value
+)
+{
+    auto f = [first, last, &value](auto policy)
+             { return internal::uninitialized_fill_impl(policy, first, last, value); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt>
+void uninitialized_value_construct(
+    ExecutionPolicy&& policy, ForwardIt first, ForwardIt last,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    internal::uninitialized_value_construct_impl(policy, first, last);
+}
+
+template <typename ForwardIt>
+void uninitialized_value_construct(
+    execution_policy policy, ForwardIt first, ForwardIt last
+)
+{
+    auto f = [first, last](auto policy)
+             { return internal::uninitialized_value_construct_impl(policy, first, last); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt>
+void destroy(
+    ExecutionPolicy&& policy, ForwardIt first, ForwardIt last,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    internal::destroy_impl(policy, first, last);
+}
+
+template <typename ForwardIt>
+void destroy(execution_policy policy, ForwardIt first, ForwardIt last)
+{
+    auto f = [first, last](auto policy)
+             { return internal::destroy_impl(policy, first, last); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt, typename Size>
+ForwardIt destroy_n(
+    ExecutionPolicy&& policy, ForwardIt first, Size n,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    const auto last = std::next(first, n);
+    internal::destroy_impl(policy, first, last);
+    return last;
+}
+
+template <typename ForwardIt, typename Size>
+ForwardIt destroy_n(execution_policy policy, ForwardIt first, Size n)
+{
+    const auto last = std::next(first, n);
+    auto f = [first, last](auto policy)
+             { return internal::destroy_impl(policy, first, last); };
+    internal::dispatch(policy, f);
+    return last;
+}
+
+} // end namespace parallel
+} // end namespace experimental
@@ -0,0 +1,599 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "count.hpp"
+#include "dispatch.hpp"
+#include "execution_policy.hpp"
+#include "reduce.hpp"
+#include "thread_pool.hpp"
+#include "uninitialized.hpp"
+
+// Collapsing runs of equivalent elements:
+//
+//     using namespace experimental::parallel;
+//     auto last = unique(par, ids.begin(), ids.end());
+//     auto ends = reduce_by_key(par, keys.begin(), keys.end(), values.begin(),
+//                               out_keys.begin(), out_values.begin());
+//
+// An element starts a run unless it is equivalent to the one before it. The
+// parallel versions make two passes over the same chunks: the first counts
+// the runs that start in every chunk (looking back across the chunk's left
+// edge for its first element), and a prefix sum over the counts gives every
+// chunk the output position of its first run, where the second pass writes.
+//
+// In reduce_by_key a run can cross any number of chunk edges. Every chunk
+// reduces the runs that start in it as far as its own end, and also the
+// elements before its first run start; those are folded into the previous
+// chunk's last run in a short sequential fix-up at the end. op must be
+// associative; its output values are read back for the fix-up, so the value
+// output must be random access. Under par_deterministic the range is cut into
+// blocks of deterministic_block_size elements instead of chunks, so where a
+// run's partial results are combined doesn't depend on the thread count.
+//
+// unique moves the elements it keeps into a temporary buffer and back, and
+// falls back to std::unique if the buffer can't be allocated. Other iterators
+// are handled sequentially.
+
+namespace experimental
+{
+namespace parallel
+{
+namespace internal
+{
+
+//================================================================================
+
+// Whether element i of the range at begin starts a run.
+template <typename RandomIt, typename BinaryPredicate>
+bool run_head(RandomIt begin, std::size_t i, BinaryPredicate& pred)
+{
+    return i == 0 || !pred(begin[i - 1], begin[i]);
+}
+
+// The pieces [0, size) is cut into for the passes over a range: the chunks,
+// or blocks of a fixed size (when block isn't zero).
+struct run_segments
+{
+    std::size_t size;
+    std::size_t count;
+    std::size_t block;
+
+    std::size_t begin(std::size_t i) const
+    { return block != 0 ? std::min(size, i * block) : chunk_begin(i, count, size); }
+};
+
+inline run_segments chunk_segments(std::size_t size)
+{
+    return { size, chunk_count(size), 0 };
+}
+
+inline run_segments block_segments(std::size_t size)
+{
+    return { size, (size + deterministic_block_size - 1) / deterministic_block_size,
+             deterministic_block_size };
+}
+
+// Calls f(i, first, last) for every segment, spread over the pool.
+template <typename Func>
+void for_each_segment(const run_segments& segments, Func f)
+{
+    for_each_chunk(segments.count, [&segments, &f](std::size_t, std::size_t first, std::size_t last) {
+        for(auto i = first; i != last; ++i) { f(i, segments.begin(i), segments.begin(i + 1)); }
+    });
+}
+
+struct run_chunk
+{
+    std::size_t offset; // Output position of the segment's first run.
+    bool head;          // Whether the segment's first element starts a run.
+};
+
+template <std::size_t Inline>
+using run_chunks = inline_buffer<run_chunk, Inline>;
+
+// First pass: counts the runs starting in each segment and turns the counts
+// into offsets. Returns the total number of runs.
+template <typename RandomIt, typename BinaryPredicate, std::size_t Inline>
+std::size_t count_runs(
+    RandomIt begin, const run_segments& segments, BinaryPredicate& pred,
+    run_chunks<Inline>& chunks
+)
+{
+    for(std::size_t i = 0; i < segments.count; ++i) { chunks.emplace_back(run_chunk{0, false}); }
+
+    for_each_segment(segments,
+        [begin, &pred, &chunks](std::size_t i, std::size_t first, std::size_t last) {
+            auto& c = chunks[i];
+            c.head = run_head(begin, first, pred);
+            std::size_t heads = c.head;
+            for(auto j = first + 1; j < last; ++j) { heads += !pred(begin[j - 1], begin[j]); }
+            c.offset = heads;
+        });
+
+    std::size_t total = 0;
+    for(auto& c : chunks) { total += std::exchange(c.offset, total); }
+    return total;
+}
+
+template <typename Iterator1, typename Iterator2, typename Iterator3, typename Iterator4>
+constexpr bool is_random_by_key_v =
+    is_random_iterator_v<Iterator1> && is_random_iterator_v<Iterator2> &&
+    is_random_iterator_v<Iterator3> && is_random_iterator_v<Iterator4>;
+
+//================================================================================
+//=====================================Unique=====================================
+//================================================================================
+
+template <typename InputIt, typename OutputIt, typename BinaryPredicate>
+OutputIt unique_copy_impl(
+    sequential_execution_policy, InputIt first, InputIt last, OutputIt out,
+    BinaryPredicate pred
+)
+{
+    return std::unique_copy(first, last, out, pred);
+}
+
+template <typename RandomIt1, typename RandomIt2, typename BinaryPredicate>
+RandomIt2 unique_copy_impl(
+    parallel_execution_policy, RandomIt1 first, RandomIt1 last, RandomIt2 out,
+    BinaryPredicate pred, enable_if_random_pair<RandomIt1, RandomIt2>* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(first, last));
+    if(size == 0) { return out; }
+
+    const auto segments = chunk_segments(size);
+    run_chunks<inline_slots<run_chunk>> chunks(segments.count);
+    const auto total = count_runs(first, segments, pred, chunks);
+
+    for_each_segment(segments,
+        [first, out, &pred, &chunks](std::size_t i, std::size_t begin, std::size_t end) {
+            auto o = out + chunks[i].offset;
+            if(chunks[i].head) { *o = first[begin]; ++o; }
+            for(auto j = begin + 1; j < end; ++j) {
+                if(!pred(first[j - 1], first[j])) { *o = first[j]; ++o; }
+            }
+        });
+
+    return out + total;
+}
+
+template <typename InputIt, typename OutputIt, typename BinaryPredicate>
+OutputIt unique_copy_impl(
+    parallel_execution_policy, InputIt first, InputIt last, OutputIt out,
+    BinaryPredicate pred, enable_if_not_random_pair<InputIt, OutputIt>* = 0
+)
+{
+    return std::unique_copy(first, last, out, pred);
+}
+
+template <typename InputIt, typename OutputIt, typename BinaryPredicate>
+OutputIt unique_copy_impl(
+    parallel_vector_execution_policy, InputIt first, InputIt last, OutputIt out,
+    BinaryPredicate pred
+)
+{
+    return unique_copy_impl(par, first, last, out, pred);
+}
+
+//================================================================================
+
+template <typename ForwardIt, typename BinaryPredicate>
+ForwardIt unique_impl(
+    sequential_execution_policy, ForwardIt first, ForwardIt last, BinaryPredicate pred
+)
+{
+    return std::unique(first, last, pred);
+}
+
+// The kept elements are moved out into a buffer at their final positions,
+// then moved back. A chunk looks at the next pair before moving an element
+// out, and the pair across its right edge was compared in the first pass.
+template <typename RandomIt, typename BinaryPredicate>
+RandomIt unique_impl(
+    parallel_execution_policy, RandomIt first, RandomIt last, BinaryPredicate pred,
+    enable_if_random<RandomIt>* = 0
+)
+{
+    using value_type = iter_value_t<RandomIt>;
+
+    const auto size = static_cast<std::size_t>(std::distance(first, last));
+    if(size == 0) { return last; }
+
+    const auto segments = chunk_segments(size);
+    const auto n = segments.count;
+    run_chunks<inline_slots<run_chunk>> chunks(n);
+    const auto total = count_runs(first, segments, pred, chunks);
+    if(total == size) { return last; }
+
+    raw_buffer<value_type> buffer(total);
+    auto* kept = buffer.data();
+    if(!kept) { return std::unique(first, last, pred); }
+
+    struct slot { bool done; };
+    inline_buffer<slot, inline_slots<slot>> done(n);
+    for(std::size_t i = 0; i < n; ++i) { done.emplace_back(slot{false}); }
+    std::atomic<bool> failed{false};
+
+    try {
+        for_each_segment(segments,
+            [first, kept, &pred, &chunks, &done, &failed](std::size_t i, std::size_t begin, std::size_t end) {
+                if(failed.load(std::memory_order_relaxed)) { return; }
+                auto* const dest = kept + chunks[i].offset;
+                auto* o = dest;
+                try {
+                    bool keep = chunks[i].head;
+                    for(auto j = begin; j < end; ++j) {
+                        const bool keep_next = j + 1 < end && !pred(first[j], first[j + 1]);
+                        if(keep) { ::new(static_cast<void*>(o)) value_type(std::move(first[j])); ++o; }
+                        keep = keep_next;
+                    }
+                }
+                catch(...) {
+                    destroy_range(dest, o);
+                    failed.store(true, std::memory_order_relaxed);
+                    throw;
+                }
+                done[i].done = true;
+            });
+    }
+    catch(...) {
+        for(std::size_t i = 0; i < n; ++i) {
+            if(done[i].done) {
+                const auto end = i + 1 < n ? chunks[i + 1].offset : total;
+                destroy_range(kept + chunks[i].offset, kept + end);
+            }
+        }
+        throw;
+    }
+    buffer.constructed(total);
+
+    for_each_chunk(total, [first, kept](std::size_t, std::size_t begin, std::size_t end) {
+        std::move(kept + begin, kept + end, first + begin);
+    });
+
+    return first + total;
+}
+
+template <typename ForwardIt, typename BinaryPredicate>
+ForwardIt unique_impl(
+    parallel_execution_policy, ForwardIt first, ForwardIt last, BinaryPredicate pred,
+    enable_if_not_random<ForwardIt>* = 0
+)
+{
+    return std::unique(first, last, pred);
+}
+
+template <typename ForwardIt, typename BinaryPredicate>
+ForwardIt unique_impl(
+    parallel_vector_execution_policy, ForwardIt first, ForwardIt last, BinaryPredicate pred
+)
+{
+    return unique_impl(par, first, last, pred);
+}
+
+//================================================================================
+//=================================Reduce By Key==================================
+//================================================================================
+
+template <
+    typename ForwardIt1, typename InputIt2, typename OutputIt1, typename OutputIt2,
+    typename BinaryPredicate, typename BinaryOp
+>
+std::pair<OutputIt1, OutputIt2> reduce_by_key_impl(
+    sequential_execution_policy, ForwardIt1 keys_first, ForwardIt1 keys_last,
+    InputIt2 values_first, OutputIt1 keys_out, OutputIt2 values_out,
+    BinaryPredicate pred, BinaryOp op
+)
+{
+    using value_type = iter_value_t<InputIt2>;
+
+    if(keys_first == keys_last) { return { keys_out, values_out }; }
+
+    auto head = keys_first;
+    value_type acc = *values_first;
+    for(auto prev = keys_first; ++keys_first != keys_last; prev = keys_first) {
+        ++values_first;
+        if(pred(*prev, *keys_first)) {
+            acc = op(std::move(acc), *values_first);
+            continue;
+        }
+        *keys_out = *head; ++keys_out;
+        *values_out = std::move(acc); ++values_out;
+        head = keys_first;
+        acc = *values_first;
+    }
+    *keys_out = *head; ++keys_out;
+    *values_out = std::move(acc); ++values_out;
+    return { keys_out, values_out };
+}
+
+// The parallel reduce_by_key over the given segments of the range.
+template <
+    typename RandomIt1, typename RandomIt2, typename RandomIt3, typename RandomIt4,
+    typename BinaryPredicate, typename BinaryOp
+>
+std::pair<RandomIt3, RandomIt4> reduce_runs(
+    const run_segments& segments, RandomIt1 keys_first, RandomIt2 values_first,
+    RandomIt3 keys_out, RandomIt4 values_out, BinaryPredicate& pred, BinaryOp& op
+)
+{
+    using value_type = iter_value_t<RandomIt2>;
+
+    const auto n = segments.count;
+    run_chunks<inline_slots<run_chunk>> chunks(n);
+    const auto total = count_runs(keys_first, segments, pred, chunks);
+
+    // The reductions of the elements before each segment's first run start.
+    std::vector<value_type> leading;
+    leading.reserve(n);
+    for(std::size_t i = 0; i < n; ++i) { leading.push_back(values_first[segments.begin(i)]); }
+
+    for_each_segment(segments,
+        [=, &pred, &op, &chunks, &leading](std::size_t i, std::size_t begin, std::size_t end) {
+            auto reduce_run = [&](std::size_t& j) {
+                value_type acc = values_first[j];
+                for(++j; j < end && pred(keys_first[j - 1], keys_first[j]); ++j) {
+                    acc = op(std::move(acc), values_first[j]);
+                }
+                return acc;
+            };
+
+            auto j = begin;
+            if(!chunks[i].head) { leading[i] = reduce_run(j); }
+            for(auto o = chunks[i].offset; j < end; ++o) {
+                keys_out[o] = keys_first[j];
+                values_out[o] = reduce_run(j);
+            }
+        });
+
+    // The run that was open at the end of segment i - 1 was the last one
+    // written before segment i's first.
+    for(std::size_t i = 1; i < n; ++i) {
+        if(chunks[i].head) { continue; }
+        const auto o = chunks[i].offset - 1;
+        values_out[o] = op(std::move(values_out[o]), std::move(leading[i]));
+    }
+
+    return { keys_out + total, values_out + total };
+}
+
+template <
+    typename RandomIt1, typename RandomIt2, typename RandomIt3, typename RandomIt4,
+    typename BinaryPredicate, typename BinaryOp
+>
+std::pair<RandomIt3, RandomIt4> reduce_by_key_impl(
+    parallel_execution_policy, RandomIt1 keys_first, RandomIt1 keys_last,
+    RandomIt2 values_first, RandomIt3 keys_out, RandomIt4 values_out,
+    BinaryPredicate pred, BinaryOp op,
+    typename std::enable_if<is_random_by_key_v<RandomIt1, RandomIt2, RandomIt3, RandomIt4>>::type* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(keys_first, keys_last));
+    if(size == 0) { return { keys_out, values_out }; }
+
+    return reduce_runs(chunk_segments(size), keys_first, values_first, keys_out, values_out,
+                       pred, op);
+}
+
+// Without random access, par_deterministic takes par's sequential fallback
+// below, which is deterministic anyway.
+template <
+    typename RandomIt1, typename RandomIt2, typename RandomIt3, typename RandomIt4,
+    typename BinaryPredicate, typename BinaryOp
+>
+std::pair<RandomIt3, RandomIt4> reduce_by_key_impl(
+    parallel_deterministic_execution_policy, RandomIt1 keys_first, RandomIt1 keys_last,
+    RandomIt2 values_first, RandomIt3 keys_out, RandomIt4 values_out,
+    BinaryPredicate pred, BinaryOp op,
+    typename std::enable_if<is_random_by_key_v<RandomIt1, RandomIt2, RandomIt3, RandomIt4>>::type* = 0
+)
+{
+    const auto size = static_cast<std::size_t>(std::distance(keys_first, keys_last));
+    if(size == 0) { return { keys_out, values_out }; }
+
+    return reduce_runs(block_segments(size), keys_first, values_first, keys_out, values_out,
+                       pred, op);
+}
+
+template <
+    typename ForwardIt1, typename InputIt2, typename OutputIt1, typename OutputIt2,
+    typename BinaryPredicate, typename BinaryOp
+>
+std::pair<OutputIt1, OutputIt2> reduce_by_key_impl(
+    parallel_execution_policy, ForwardIt1 keys_first, ForwardIt1 keys_last,
+    InputIt2 values_first, OutputIt1 keys_out, OutputIt2 values_out,
+    BinaryPredicate pred, BinaryOp op,
+    typename std::enable_if<!is_random_by_key_v<ForwardIt1, InputIt2, OutputIt1, OutputIt2>>::type* = 0
+)
+{
+    return reduce_by_key_impl(seq, keys_first, keys_last, values_first, keys_out, values_out,
+                              pred, op);
+}
+
+template <
+    typename ForwardIt1, typename InputIt2, typename OutputIt1, typename OutputIt2,
+    typename BinaryPredicate, typename BinaryOp
+>
+std::pair<OutputIt1, OutputIt2> reduce_by_key_impl(
+    parallel_vector_execution_policy, ForwardIt1 keys_first, ForwardIt1 keys_last,
+    InputIt2 values_first, OutputIt1 keys_out, OutputIt2 values_out,
+    BinaryPredicate pred, BinaryOp op
+)
+{
+    return reduce_by_key_impl(par, keys_first, keys_last, values_first, keys_out, values_out,
+                              pred, op);
+}
+
+} // end namespace internal
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename ForwardIt, typename BinaryPredicate>
+ForwardIt unique(
+    ExecutionPolicy&& policy, ForwardIt first, ForwardIt last, BinaryPredicate pred,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::unique_impl(policy, first, last, pred);
+}
+
+template <typename ForwardIt, typename BinaryPredicate>
+ForwardIt unique(
+    execution_policy policy, ForwardIt first, ForwardIt last, BinaryPredicate pred
+)
+{
+    auto f = [first, last, pred](auto policy)
+             { return internal::unique_impl(policy, first, last, pred); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename ForwardIt>
+ForwardIt unique(
+    ExecutionPolicy&& policy, ForwardIt first, ForwardIt last,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::unique_impl(policy, first, last, std::equal_to<>{});
+}
+
+template <typename ForwardIt>
+ForwardIt unique(
+    execution_policy policy, ForwardIt first, ForwardIt last
+)
+{
+    return unique(policy, first, last, std::equal_to<>{});
+}
+
+//================================================================================
+
+template <typename ExecutionPolicy, typename InputIt, typename OutputIt, typename BinaryPredicate>
+OutputIt unique_copy(
+    ExecutionPolicy&& policy, InputIt first, InputIt last, OutputIt out, BinaryPredicate pred,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::unique_copy_impl(policy, first, last, out, pred);
+}
+
+template <typename InputIt, typename OutputIt, typename BinaryPredicate>
+OutputIt unique_copy(
+    execution_policy policy, InputIt first, InputIt last, OutputIt out, BinaryPredicate pred
+)
+{
+    auto f = [first, last, out, pred](auto policy)
+             { return internal::unique_copy_impl(policy, first, last, out, pred); };
+    return internal::dispatch(policy, f);
+}
+
+template <typename ExecutionPolicy, typename InputIt, typename OutputIt>
+OutputIt unique_copy(
+    ExecutionPolicy&& policy, InputIt first, InputIt last, OutputIt out,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::unique_copy_impl(policy, first, last, out, std::equal_to<>{});
+}
+
+template <typename InputIt, typename OutputIt>
+OutputIt unique_copy(
+    execution_policy policy, InputIt first, InputIt last, OutputIt out
+)
+{
+    return unique_copy(policy, first, last, out, std::equal_to<>{});
+}
+
+//================================================================================
+
+// Writes the key of every run of equivalent keys to keys_out, and the values
+// of the run reduced with op to values_out. Returns the ends of both outputs.
+template <
+    typename ExecutionPolicy, typename ForwardIt1, typename InputIt2,
+    typename OutputIt1, typename OutputIt2, typename BinaryPredicate, typename BinaryOp
+>
+std::pair<OutputIt1, OutputIt2> reduce_by_key(
+    ExecutionPolicy&& policy, ForwardIt1 keys_first, ForwardIt1 keys_last,
+    InputIt2 values_first, OutputIt1 keys_out, OutputIt2 values_out,
+    BinaryPredicate pred, BinaryOp op,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::reduce_by_key_impl(policy, keys_first, keys_last, values_first,
+                                        keys_out, values_out, pred, op);
+}
+
+template <
+    typename ForwardIt1, typename InputIt2, typename OutputIt1, typename OutputIt2,
+    typename BinaryPredicate, typename BinaryOp
+>
+std::pair<OutputIt1, OutputIt2> reduce_by_key(
+    execution_policy policy, ForwardIt1 keys_first, ForwardIt1 keys_last,
+    InputIt2 values_first, OutputIt1 keys_out, OutputIt2 values_out,
+    BinaryPredicate pred, BinaryOp op
+)
+{
+    auto f = [keys_first, keys_last, values_first, keys_out, values_out, pred, op](auto policy)
+             { return internal::reduce_by_key_impl(policy, keys_first, keys_last, values_first,
+                                                   keys_out, values_out, pred, op); };
+    return internal::dispatch(policy, f);
+}
+
+template <
+    typename ExecutionPolicy, typename ForwardIt1, typename InputIt2,
+    typename OutputIt1, typename OutputIt2, typename BinaryOp
+>
+std::pair<OutputIt1, OutputIt2> reduce_by_key(
+    ExecutionPolicy&& policy, ForwardIt1 keys_first, ForwardIt1 keys_last,
+    InputIt2 values_first, OutputIt1 keys_out, OutputIt2 values_out, BinaryOp op,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::reduce_by_key_impl(policy, keys_first, keys_last, values_first,
+                                        keys_out, values_out, std::equal_to<>{}, op);
+}
+
+template <typename ForwardIt1, typename InputIt2, typename OutputIt1, typename OutputIt2, typename BinaryOp>
+std::pair<OutputIt1, OutputIt2> reduce_by_key(
+    execution_policy policy, ForwardIt1 keys_first, ForwardIt1 keys_last,
+    InputIt2 values_first, OutputIt1 keys_out, OutputIt2 values_out, BinaryOp op
+)
+{
+    return reduce_by_key(policy, keys_first, keys_last, values_first, keys_out, values_out,
+                         std::equal_to<>{}, op);
+}
+
+template <
+    typename ExecutionPolicy, typename ForwardIt1, typename InputIt2,
+    typename OutputIt1, typename OutputIt2
+>
+std::pair<OutputIt1, OutputIt2> reduce_by_key(
+    ExecutionPolicy&& policy, ForwardIt1 keys_first, ForwardIt1 keys_last,
+    InputIt2 values_first, OutputIt1 keys_out, OutputIt2 values_out,
+    typename std::enable_if<is_execution_policy_v<std::decay_t<ExecutionPolicy>>>::type* = 0
+)
+{
+    return internal::reduce_by_key_impl(policy, keys_first, keys_last, values_first,
+                                        keys_out, values_out, std::equal_to<>{}, std::plus<>{});
+}
+
+template <typename ForwardIt1, typename InputIt2, typename OutputIt1, typename OutputIt2>
+std::pair<OutputIt1, OutputIt2> reduce_by_key(
+    execution_policy policy, ForwardIt1 keys_first, ForwardIt1 keys_last,
+    InputIt2 values_first, OutputIt1 keys_out, OutputIt2 values_out
+)
+{
+    return reduce_by_key(policy, keys_first, keys_last, values_first, keys_out, values_out,
+                         std::equal_to<>{}, std::plus<>{});
+}
+
+} // end namespace parallel
+} // end namespace experimental
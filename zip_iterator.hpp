@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "contiguous_iterator.hpp"
+#include "iterator_operators.hpp"
+
+// Iterates over several ranges in lockstep; dereferencing gives a tuple of
+// references into each of them. views::zip (pipeline.hpp) builds ranges of
+// these, and it can be handed to the algorithms directly:
+//
+//     zip_iterator<float*, float*, float*> first(x, y, z), last(x + n, y + n, z + n);
+//     for_each(par_vec, first, last, [](auto t) { std::get<0>(t) += std::get<1>(t) * std::get<2>(t); });
+//
+// It is random access whenever all the zipped iterators are, so the parallel
+// algorithms chunk it like any other range. When all of them are contiguous
+// (separate arrays, i.e. a structure of arrays), the par_vec overloads of
+// for_each and count go through zip_pointers instead, which indexes one raw
+// pointer per array so that each array streams through a plain counted loop
+// the compiler can vectorize.
+
+namespace experimental
+{
+namespace parallel
+{
+
+//================================================================================
+
+template <typename... Iterators>
+class zip_iterator
+    : public internal::random_access_operators<
+          zip_iterator<Iterators...>,
+          std::ptrdiff_t
+      >
+{
+public:
+
+    using iterator_category =
+        std::common_type_t<
+            typename std::iterator_traits<Iterators>::iterator_category...,
+            std::random_access_iterator_tag
+        >;
+    using difference_type = std::ptrdiff_t;
+    using value_type =
+        std::tuple<typename std::iterator_traits<Iterators>::value_type...>;
+    using reference =
+        std::tuple<typename std::iterator_traits<Iterators>::reference...>;
+    using pointer = void;
+
+    zip_iterator() = default;
+
+    explicit zip_iterator(Iterators... its)
+        : its(its...)
+    { }
+
+    reference operator*() const
+    { return deref(std::index_sequence_for<Iterators...>{}); }
+
+    reference operator[](difference_type n) const
+    { return *(*this + n); }
+
+    const std::tuple<Iterators...>& iterators() const { return its; }
+
+    void advance(difference_type n)
+    { advance(n, std::index_sequence_for<Iterators...>{}); }
+
+    difference_type distance_to(const zip_iterator& other) const
+    { return std::distance(std::get<0>(its), std::get<0>(other.its)); }
+    bool equal(const zip_iterator& other) const
+    { return std::get<0>(its) == std::get<0>(other.its); }
+
+private:
+
+    template <std::size_t... I>
+    reference deref(std::index_sequence<I...>) const
+    { return reference(*std::get<I>(its)...); }
+
+    template <std::size_t... I>
+    void advance(difference_type n, std::index_sequence<I...>)
+    {
+        using expand = int[];
+        (void)expand{ 0, (std::advance(std::get<I>(its), n), 0)... };
+    }
+
+    std::tuple<Iterators...> its;
+};
+
+namespace internal
+{
+
+//================================================================================
+
+template <bool... Values>
+struct all_true
+    : std::is_same<all_true<Values..., true>, all_true<true, Values...>>
+{ };
+
+template <typename Iterator>
+struct is_contiguous_zip
+    : std::integral_constant<bool, false>
+{ };
+
+template <typename... Iterators>
+struct is_contiguous_zip<zip_iterator<Iterators...>>
+    : all_true<is_contiguous_iterator_v<Iterators>...>
+{ };
+
+template <typename Iterator>
+constexpr bool is_contiguous_zip_v = is_contiguous_zip<Iterator>::value;
+
+// The zipped arrays as one raw pointer each. The zip iterator it is built
+// from must be dereferenceable.
+template <typename... Iterators>
+class zip_pointers
+{
+public:
+
+    using reference = typename zip_iterator<Iterators...>::reference;
+
+    explicit zip_pointers(const zip_iterator<Iterators...>& it)
+        : ptrs(make(it.iterators(), std::index_sequence_for<Iterators...>{}))
+    { }
+
+    reference operator[](std::size_t j) const
+    { return index(j, std::index_sequence_for<Iterators...>{}); }
+
+private:
+
+    using pointers =
+        std::tuple<decltype(to_pointer(std::declval<Iterators>()))...>;
+
+    template <std::size_t... I>
+    static pointers make(const std::tuple<Iterators...>& its, std::index_sequence<I...>)
+    { return pointers(to_pointer(std::get<I>(its))...); }
+
+    template <std::size_t... I>
+    reference index(std::size_t j, std::index_sequence<I...>) const
+    { return reference(std::get<I>(ptrs)[j]...); }
+
+    pointers ptrs;
+};
+
+} // end namespace internal
+} // end namespace parallel
+} // end namespace experimental